@@ -35,6 +35,10 @@
 
 #include "dsl-pa/dsl-pa.h"
 
+#if __cplusplus >= 201103L
+    #include <thread>
+#endif
+
 using namespace cl;
 
 TFUNCTION( alphabet_test )
@@ -127,6 +131,46 @@ TFUNCTION( alphabet_combiners_test )
     TTEST( ! a_to_f_not_c.is_sought( '0' ) );
 }
 
+TFUNCTION( alphabet_flat_test )
+{
+    TBEGIN( "Alphabet flat tests" );
+
+    // Flattened alphabets can be made from temporaries
+    alphabet_flat name_chars = alphabet_or( alphabet_word_char(), alphabet_or( alphabet_dash(), alphabet_point() ) ).flatten();
+    alphabet_flat a_to_f_not_c = alphabet_and( alphabet_char_class( "a-f" ), alphabet_not( alphabet_char( 'c' ) ) ).flatten();
+    alphabet_digit digit;
+    alphabet_not not_digit_combiner( digit );
+    alphabet_flat not_digit( not_digit_combiner );
+
+    TTEST( name_chars.is_sought( 'a' ) );
+    TTEST( name_chars.is_sought( '_' ) );
+    TTEST( name_chars.is_sought( '-' ) );
+    TTEST( name_chars.is_sought( '.' ) );
+    TTEST( ! name_chars.is_sought( ' ' ) );
+    TTEST( a_to_f_not_c.is_sought( 'b' ) );
+    TTEST( ! a_to_f_not_c.is_sought( 'c' ) );
+    TTEST( ! a_to_f_not_c.is_sought( '0' ) );
+    TTEST( not_digit.is_sought( 'x' ) );
+    TTEST( ! not_digit.is_sought( '1' ) );
+    TTEST( ! not_digit.is_sought( '\0' ) );    // alphabet_not doesn't seek EOI
+    TTEST( name_chars.get_char_map() != 0 );
+
+    {
+    reader_string my_reader( "my-name.x y" );
+    dsl_pa my_pa( my_reader );
+    std::string name;
+    TTEST( my_pa.get( &name, name_chars ) == 9 );
+    TTEST( name == "my-name.x" );
+    }
+
+    {
+    using namespace cl::short_alphabets;
+    flat my_name_chars = Or( word_char(), dash() ).flatten();
+    TTEST( my_name_chars.is_sought( '-' ) );
+    TTEST( ! my_name_chars.is_sought( '.' ) );
+    }
+}
+
 TFUNCTION( alphabet_typedefed_test )
 {
     TBEGIN( "Alphabet typedefed tests" );
@@ -219,6 +263,8 @@ TFUNCTION( alphabet_char_map_test )
 {
     TBEGIN( "Alphabet char_map tests" );
 
+    TTEST( sizeof( char_map ) == 32 );
+
     char_map my_map;
 
     TTEST( ! my_map.is_set( 'a' ) );
@@ -324,6 +370,328 @@ TFUNCTION( alphabet_char_map_test )
     TTEST( ! my_map.is_set( 'f' ) );
 }
 
+namespace {
+
+const char * find_first_slowly( const char_map & r_map, const char * p_begin, const char * p_end, bool is_set_sought )
+{
+    while( p_begin != p_end && r_map.is_set( *p_begin ) != is_set_sought )
+        ++p_begin;
+    return p_begin;
+}
+
+bool is_find_first_ok( const char_map & r_map )
+{
+    // Every char in every position of blocks of different sizes and alignments
+    std::string input;
+    for( int i = 0; i < 3 * 256; ++i )
+        input += static_cast< char >( i * 7 );
+    const char * p_begin = input.data();
+
+    for( size_t start = 0; start < 70; ++start )
+        for( size_t length = 0; length < input.size() - start; length += 1 + length / 4 )
+        {
+            if( r_map.find_first_set( p_begin + start, p_begin + start + length ) !=
+                    find_first_slowly( r_map, p_begin + start, p_begin + start + length, true ) ||
+                    r_map.find_first_not_set( p_begin + start, p_begin + start + length ) !=
+                    find_first_slowly( r_map, p_begin + start, p_begin + start + length, false ) )
+                return false;
+        }
+
+    // Long runs of set and unset chars
+    for( int i = 0; i < 256; ++i )
+    {
+        std::string run( 100, static_cast< char >( i ) );
+        run += static_cast< char >( i + 1 );
+        const char * p_run_end = run.data() + run.size();
+        if( r_map.find_first_set( run.data(), p_run_end ) != find_first_slowly( r_map, run.data(), p_run_end, true ) ||
+                r_map.find_first_not_set( run.data(), p_run_end ) != find_first_slowly( r_map, run.data(), p_run_end, false ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool is_char_map_same_as_alphabet( const alphabet & r_alphabet )
+{
+    const char_map * p_map = r_alphabet.get_char_map();
+    if( ! p_map )
+        return false;
+    for( int i = 0; i < 256; ++i )
+        if( p_map->is_set( static_cast< char >( i ) ) != r_alphabet.is_sought( static_cast< char >( i ) ) )
+            return false;
+    return true;
+}
+
+// Built-in alphabets' char maps must be usable during static initialisation
+const size_t digits_at_static_init = alphabet_digit().sought_prefix_length( "0123456789012345678x", "0123456789012345678x" + 20 );
+
+} // End of anonymous namespace
+
+TFUNCTION( alphabet_char_map_find_first_test )
+{
+    TBEGIN( "Alphabet char_map find_first tests" );
+
+    TTEST( is_find_first_ok( char_map() ) );
+    TTEST( is_find_first_ok( char_map().invert() ) );
+    TTEST( is_find_first_ok( char_map().set( 'a' ) ) );
+    TTEST( is_find_first_ok( char_map().set( '\xff' ).set( '\x80' ).set( '\x7f' ).set( '\0' ) ) );
+    TTEST( is_find_first_ok( char_map_w() ) );
+    TTEST( is_find_first_ok( char_map_s().invert() ) );
+    TTEST( is_find_first_ok( char_map().set_range( '\x30', '\xc7' ) ) );
+    TTEST( is_find_first_ok( char_map().set_range( '\x30', '\xc7' ).invert() ) );
+    TTEST( is_find_first_ok( char_map().set_inverted_range( '\x01', '\x7f' ) ) );
+
+    {
+    char_map my_map;
+    my_map.merge( char_map().set_range( 'a', 'z' ) );
+    my_map.merge( char_map().set( '\xe9' ) );
+    my_map.clear( 'q' );
+    TTEST( is_find_first_ok( my_map ) );
+    }
+
+    TDOC( "Char maps of built-in alphabets" );
+    TTEST( is_char_map_same_as_alphabet( alphabet_space() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_line_space() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_eol() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_digit() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_hex() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_alpha() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_word_first_char() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_word_char() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_name_char() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_uni() ) );
+    TTEST( is_char_map_same_as_alphabet( alphabet_char_class( "^a-f~d" ) ) );
+    TTEST( alphabet_char( 'a' ).get_char_map() == 0 );
+    TTEST( digits_at_static_init == 19 );
+}
+
+namespace {
+
+bool is_prefix_length_ok( const alphabet & r_alphabet )
+{
+    const char * inputs[] = { "", "a", "aaab", "abcABC123 ;;x", "123abc", ";;;;a", "\0abc", "ab\0cd", "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" };
+    size_t lengths[] = { 0, 1, 4, 13, 6, 5, 4, 5, 40 };
+
+    for( size_t i = 0; i < sizeof( inputs ) / sizeof( inputs[0] ); ++i )
+    {
+        const char * p_begin = inputs[i];
+        const char * p_end = p_begin + lengths[i];
+
+        size_t n_sought = 0;
+        while( p_begin + n_sought != p_end && r_alphabet.is_sought( p_begin[n_sought] ) )
+            ++n_sought;
+        size_t n_unsought = 0;
+        while( p_begin + n_unsought != p_end && ! r_alphabet.is_sought( p_begin[n_unsought] ) )
+            ++n_unsought;
+
+        if( r_alphabet.sought_prefix_length( p_begin, p_end ) != n_sought ||
+                r_alphabet.unsought_prefix_length( p_begin, p_end ) != n_unsought )
+            return false;
+    }
+    return true;
+}
+
+bool is_a_or_semicolon( char c )
+{
+    return c == 'a' || c == ';';
+}
+
+} // End of anonymous namespace
+
+TFUNCTION( alphabet_prefix_length_test )
+{
+    TBEGIN( "Alphabet prefix length tests" );
+
+    TTEST( is_prefix_length_ok( alphabet_char( 'a' ) ) );
+    TTEST( is_prefix_length_ok( alphabet_char( ';' ) ) );
+    TTEST( is_prefix_length_ok( alphabet_char_class( "a-c" ) ) );
+    TTEST( is_prefix_length_ok( alphabet_digit() ) );
+    TTEST( is_prefix_length_ok( alphabet_space() ) );
+    TTEST( is_prefix_length_ok( alphabet_function( is_a_or_semicolon ) ) );
+    TTEST( is_prefix_length_ok( alphabet_semicolon() ) );
+    TTEST( is_prefix_length_ok( alphabet_not( alphabet_char( 'a' ) ) ) );
+    TTEST( is_prefix_length_ok( alphabet_not( alphabet_digit() ) ) );
+    TTEST( is_prefix_length_ok( alphabet_or( alphabet_char( 'a' ), alphabet_char( 'b' ) ) ) );
+    TTEST( is_prefix_length_ok( alphabet_or( alphabet_alpha(), alphabet_digit() ) ) );
+    TTEST( is_prefix_length_ok( alphabet_and( alphabet_alpha(), alphabet_char_class( "^b" ) ) ) );
+    TTEST( is_prefix_length_ok( alphabet_and( alphabet_not( alphabet_char( 'z' ) ), alphabet_not( alphabet_digit() ) ) ) );
+
+    TTEST( alphabet_or( alphabet_char( 'a' ), alphabet_char( 'b' ) ).sought_prefix_length( "abbaabx", "abbaabx" + 7 ) == 6 );
+    TTEST( alphabet_and( alphabet_not( alphabet_char( 'a' ) ), alphabet_not( alphabet_char( 'b' ) ) ).
+                unsought_prefix_length( "abbaabx", "abbaabx" + 7 ) == 6 );
+}
+
+namespace {
+
+class alphabet_digit_or_x : public alphabet_digit
+{
+public:
+    virtual bool is_sought( char c ) const
+    {
+        return c == 'x' || alphabet_digit::is_sought( c );
+    }
+    // Overriding is_sought() means the prefix functions must be overridden
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return sought_prefix_length_by_char( p_begin, p_end );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return unsought_prefix_length_by_char( p_begin, p_end );
+    }
+};
+
+class alphabet_a_to_c_not_b : public alphabet_char_class
+{
+public:
+    alphabet_a_to_c_not_b() : alphabet_char_class( "a-c" ) {}
+    virtual bool is_sought( char c ) const
+    {
+        return c != 'b' && alphabet_char_class::is_sought( c );
+    }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return sought_prefix_length_by_char( p_begin, p_end );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return unsought_prefix_length_by_char( p_begin, p_end );
+    }
+};
+
+class alphabet_flat_not_a : public alphabet_flat
+{
+public:
+    alphabet_flat_not_a() : alphabet_flat( alphabet_alpha() ) {}
+    virtual bool is_sought( char c ) const
+    {
+        return c != 'a' && alphabet_flat::is_sought( c );
+    }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return sought_prefix_length_by_char( p_begin, p_end );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return unsought_prefix_length_by_char( p_begin, p_end );
+    }
+};
+
+class alphabet_char_or_b : public alphabet_char
+{
+public:
+    alphabet_char_or_b() : alphabet_char( 'a' ) {}
+    virtual bool is_sought( char c ) const
+    {
+        return c == 'b' || alphabet_char::is_sought( c );
+    }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return sought_prefix_length_by_char( p_begin, p_end );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return unsought_prefix_length_by_char( p_begin, p_end );
+    }
+};
+
+bool is_a( char c )
+{
+    return c == 'a';
+}
+
+class alphabet_function_or_b : public alphabet_function
+{
+public:
+    alphabet_function_or_b() : alphabet_function( is_a ) {}
+    virtual bool is_sought( char c ) const
+    {
+        return c == 'b' || alphabet_function::is_sought( c );
+    }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return sought_prefix_length_by_char( p_begin, p_end );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return unsought_prefix_length_by_char( p_begin, p_end );
+    }
+};
+
+class alphabet_not_digit_or_b : public alphabet_not
+{
+public:
+    alphabet_not_digit_or_b() : alphabet_not( digit ) {}
+    virtual bool is_sought( char c ) const
+    {
+        return c != 'b' && alphabet_not::is_sought( c );
+    }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return sought_prefix_length_by_char( p_begin, p_end );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        return unsought_prefix_length_by_char( p_begin, p_end );
+    }
+
+private:
+    alphabet_digit digit;
+};
+
+} // End of anonymous namespace
+
+TFUNCTION( alphabet_derived_test )
+{
+    TBEGIN( "Alphabet derived from built-in alphabet tests" );
+
+    TDOC( "A derived alphabet that overrides is_sought() and the prefix functions is scanned with its is_sought()" );
+    TTEST( is_prefix_length_ok( alphabet_digit_or_x() ) );
+    TTEST( is_prefix_length_ok( alphabet_a_to_c_not_b() ) );
+    TTEST( is_prefix_length_ok( alphabet_flat_not_a() ) );
+    TTEST( is_prefix_length_ok( alphabet_char_or_b() ) );
+    TTEST( is_prefix_length_ok( alphabet_function_or_b() ) );
+    TTEST( is_prefix_length_ok( alphabet_not_digit_or_b() ) );
+    TTEST( alphabet_char_or_b().sought_prefix_length( "abbaabx", "abbaabx" + 7 ) == 6 );
+    TTEST( alphabet_char_or_b().unsought_prefix_length( "xyzbaa", "xyzbaa" + 6 ) == 3 );
+    TTEST( alphabet_function_or_b().sought_prefix_length( "abbaabx", "abbaabx" + 7 ) == 6 );
+    TTEST( alphabet_function_or_b().unsought_prefix_length( "xyzbaa", "xyzbaa" + 6 ) == 3 );
+    TTEST( alphabet_not_digit_or_b().sought_prefix_length( "xyzbaa", "xyzbaa" + 6 ) == 3 );
+
+    {
+    reader_string my_reader( "12x3x45x6789x0123456789x;ab" );
+    dsl_pa pa( my_reader );
+    std::string result;
+    TTEST( pa.get( &result, alphabet_digit_or_x() ) == 24 );
+    TTEST( result == "12x3x45x6789x0123456789x" );
+    TTEST( pa.current() == ';' );
+    }
+
+    {
+    reader_string my_reader( "12x3x45x6789x0123456789x;ab" );
+    dsl_pa pa( my_reader );
+    TTEST( pa.skip( alphabet_digit_or_x() ) == 24 );
+    TTEST( pa.current() == ';' );
+    }
+
+    {
+    reader_string my_reader( "ccaaccaaccaaccaaccaacbcc" );
+    dsl_pa pa( my_reader );
+    std::string result;
+    TTEST( pa.get_until( &result, alphabet_not( alphabet_a_to_c_not_b() ) ) == 21 );
+    TTEST( result == "ccaaccaaccaaccaaccaac" );
+    TTEST( pa.current() == 'b' );
+    }
+
+    {
+    reader_string my_reader( "zyxwvutsrqponmlkjihgfedcbaz" );
+    dsl_pa pa( my_reader );
+    std::string result;
+    TTEST( pa.get( &result, alphabet_flat_not_a() ) == 25 );
+    TTEST( result == "zyxwvutsrqponmlkjihgfedcb" );
+    }
+}
+
 TFUNCTION( alphabet_char_class_test )
 {
     TBEGIN( "Alphabet_char_class tests" );
@@ -425,6 +793,161 @@ TFUNCTION( alphabet_char_class_test )
     }
 }
 
+#if defined( CL_DSL_PA_CPP14 )
+namespace {
+constexpr char ct_spec_range[] = "a-dm-oxyz";
+constexpr char ct_spec_inverted[] = "^a-dm-oxyz";
+constexpr char ct_spec_specials[] = "~d~s\\w_~~~-";
+constexpr char ct_spec_inverted_specials[] = "~W~S~D~L";
+constexpr char ct_spec_uni[] = "~u";
+constexpr char ct_spec_other_specials[] = "~l~t~r~n\\\\~-";
+constexpr char ct_spec_w[] = "~w";
+constexpr char ct_spec_d[] = "~d";
+constexpr char ct_spec_l[] = "\\l";
+constexpr char ct_spec_not_w[] = "~W";
+constexpr char ct_spec_trailing_dash[] = "^a-";
+constexpr char ct_spec_trailing_tilde[] = "ab~";
+constexpr char ct_spec_empty[] = "";
+
+template< const char * p_spec >
+bool is_same_as_char_class()
+{
+    alphabet_ct< p_spec > my_ct_alphabet;
+    alphabet_char_class my_char_class( p_spec );
+    const alphabet & r_alphabet = my_ct_alphabet;
+
+    for( int i = 0; i < 256; ++i )
+    {
+        char c = static_cast< char >( i );
+        if( r_alphabet.is_sought( c ) != my_char_class.is_sought( c ) ||
+                alphabet_ct< p_spec >::is_in( c ) != my_char_class.is_sought( c ) )
+            return false;
+    }
+    return is_char_map_same_as_alphabet( my_ct_alphabet );
+}
+
+template< const char * p_spec >
+bool is_same_as_alphabet( const alphabet & r_alphabet )
+{
+    for( int i = 0; i < 256; ++i )
+        if( alphabet_ct< p_spec >::is_in( static_cast< char >( i ) ) != r_alphabet.is_sought( static_cast< char >( i ) ) )
+            return false;
+    return true;
+}
+
+static_assert( alphabet_helpers::char_class_map( ct_spec_range ).is_set( 'n' ) &&
+                ! alphabet_helpers::char_class_map( ct_spec_range ).is_set( 'p' ),
+                "char_map should be usable at compile time" );
+}
+
+TFUNCTION( alphabet_ct_test )
+{
+    TBEGIN( "Alphabet_ct tests" );
+
+    TTEST( is_same_as_char_class< ct_spec_range >() );
+    TTEST( is_same_as_char_class< ct_spec_inverted >() );
+    TTEST( is_same_as_char_class< ct_spec_specials >() );
+    TTEST( is_same_as_char_class< ct_spec_inverted_specials >() );
+    TTEST( is_same_as_char_class< ct_spec_uni >() );
+    TTEST( is_same_as_char_class< ct_spec_other_specials >() );
+    TTEST( is_same_as_char_class< ct_spec_w >() );
+    TTEST( is_same_as_char_class< ct_spec_d >() );
+    TTEST( is_same_as_char_class< ct_spec_l >() );
+    TTEST( is_same_as_char_class< ct_spec_not_w >() );
+
+    TDOC( "Special char classes are the same as the equivalent built-in alphabets" );
+    TTEST( is_same_as_alphabet< ct_spec_w >( alphabet_word_char() ) );
+    TTEST( is_same_as_alphabet< ct_spec_d >( alphabet_digit() ) );
+    TTEST( is_same_as_alphabet< ct_spec_l >( alphabet_alpha() ) );
+    TTEST( is_same_as_alphabet< ct_spec_not_w >( alphabet_not( alphabet_word_char() ) ) );
+    TTEST( is_same_as_alphabet< ct_spec_other_specials >( alphabet_or( alphabet_alpha(), alphabet_char_class( "\t\r\n~\\~-" ) ) ) );
+    TTEST( is_same_as_char_class< ct_spec_trailing_dash >() );
+    TTEST( is_same_as_char_class< ct_spec_trailing_tilde >() );
+    TTEST( is_same_as_char_class< ct_spec_empty >() );
+
+    TDOC( "Usable where an alphabet is accepted" );
+    reader_string my_reader( "beef;" );
+    dsl_pa my_pa( my_reader );
+    std::string result;
+    TTEST( my_pa.get( &result, alphabet_ct< ct_spec_range >() ) == 1 );
+    TTEST( result == "b" );
+}
+#endif
+
+#if __cplusplus >= 201103L
+namespace {
+
+void intern_char_classes( const alphabet_char_class * p_results[], size_t n_results )
+{
+    const char * specs[] = { "a-f", "IVXLCM", "~d~s" };
+    for( size_t i = 0; i < n_results; ++i )
+        p_results[i] = &alphabet_char_class::intern( specs[i % 3] );
+}
+
+} // End of anonymous namespace
+#endif
+
+TFUNCTION( alphabet_char_class_intern_test )
+{
+    TBEGIN( "Alphabet_char_class intern tests" );
+
+    const alphabet_char_class & r_roman = alphabet_char_class::intern( "IVXLCM" );
+    TTEST( r_roman.is_sought( 'X' ) );
+    TTEST( ! r_roman.is_sought( 'A' ) );
+    TTEST( &alphabet_char_class::intern( "IVXLCM" ) == &r_roman );
+    TTEST( &alphabet_char_class::intern( std::string( "IVXLCM" ).c_str() ) == &r_roman );
+    TTEST( &alphabet_char_class::intern( "IVXLC" ) != &r_roman );
+    TTEST( alphabet_char_class::intern( "^~d" ).is_sought( 'a' ) );
+    TTEST( ! alphabet_char_class::intern( "^~d" ).is_sought( '1' ) );
+
+    {
+    reader_string my_reader( "MCMXCIV year" );
+    dsl_pa my_pa( my_reader );
+    std::string roman_number;
+    TTEST( my_pa.get( &roman_number, alphabet_char_class::intern( "IVXLCM" ) ) == 7 );
+    TTEST( roman_number == "MCMXCIV" );
+    }
+
+    {
+    TDOC( "More specs than the intern table has lists" );
+    const alphabet_char_class * p_interned[200];
+    bool is_ok = true;
+    for( int i = 0; i < 200; ++i )
+    {
+        char spec[] = { 'a', static_cast< char >( 'A' + i % 26 ), static_cast< char >( '0' + i / 26 ), '\0' };
+        p_interned[i] = &alphabet_char_class::intern( spec );
+        if( ! p_interned[i]->is_sought( spec[1] ) || ! p_interned[i]->is_sought( spec[2] ) ||
+                (i > 0 && p_interned[i] == p_interned[i - 1]) )
+            is_ok = false;
+    }
+    for( int i = 0; i < 200; ++i )
+    {
+        char spec[] = { 'a', static_cast< char >( 'A' + i % 26 ), static_cast< char >( '0' + i / 26 ), '\0' };
+        if( &alphabet_char_class::intern( spec ) != p_interned[i] )
+            is_ok = false;
+    }
+    TTEST( is_ok );
+    }
+
+#if __cplusplus >= 201103L
+    TDOC( "Interning from several threads" );
+    const size_t n_threads = 4, n_results = 30;
+    const alphabet_char_class * p_results[n_threads][n_results];
+    std::vector< std::thread > threads;
+    for( size_t i = 0; i < n_threads; ++i )
+        threads.push_back( std::thread( intern_char_classes, p_results[i], n_results ) );
+    for( size_t i = 0; i < n_threads; ++i )
+        threads[i].join();
+    bool is_same = true;
+    for( size_t i = 0; i < n_threads; ++i )
+        for( size_t j = 0; j < n_results; ++j )
+            if( p_results[i][j] != p_results[0][j % 3] )
+                is_same = false;
+    TTEST( is_same );
+    TTEST( p_results[0][1] == &r_roman );
+#endif
+}
+
 bool lower_case_odd_letter( char c )
 {
     return c >= 'a' && c <= 'z' && ((c - 'a' + 1) % 2 == 1);
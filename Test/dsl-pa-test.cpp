@@ -37,6 +37,25 @@
 
 #include "dsl-pa/dsl-pa.h"
 
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#if defined( _WIN32 )
+    #include <io.h>
+#endif
+
+static int open_test_fd( const char * p_file_name )
+{
+#if defined( _WIN32 )
+    return _open( p_file_name, _O_RDONLY | _O_BINARY );
+#else
+    return open( p_file_name, O_RDONLY );
+#endif
+}
+
 using namespace cl;
 
 static bool is_false_optional_test_helper()
@@ -596,6 +615,72 @@ TFUNCTION( dsl_pa_skip_test )
     }
 }
 
+TFUNCTION( dsl_pa_long_input_test )
+{
+    TBEGIN( "dsl pa long input tests" );
+
+    // Long enough to span several reader_file and reader_fd blocks
+    std::string input( 100000, 'a' );
+    input += " Mode: ";
+    input += std::string( 100000, 'b' );
+    input += "\\;";
+    input += std::string( 100000, 'c' );
+    input += ";";
+
+    const char * p_test_data_file_name = "FoxdfEr43Df.txt";
+
+    {
+    std::ofstream fout( p_test_data_file_name, std::ios::binary );
+    TCRITICALTEST( fout.is_open() );
+    fout << input;
+    }
+
+    reader_string my_string_reader( input );
+    reader_file my_file_reader( p_test_data_file_name );
+    reader_mmap my_mmap_reader( p_test_data_file_name );
+    reader_fd my_fd_reader( open_test_fd( p_test_data_file_name ), true );
+    reader * p_readers[] = { &my_string_reader, &my_file_reader, &my_mmap_reader, &my_fd_reader };
+
+    for( size_t i = 0; i < sizeof( p_readers ) / sizeof( p_readers[0] ); ++i )
+    {
+        dsl_pa my_pa( *p_readers[i] );
+        locator my_location( my_pa );
+
+        std::string as, bs;
+
+        TTEST( my_pa.get( &as, alphabet_char( 'a' ), 99999 ) == 99999 );
+        TTEST( my_pa.current() == 'a' );
+        TTEST( my_pa.read( &as, alphabet_char( 'a' ) ) == 1 );
+        TTEST( as == std::string( 100000, 'a' ) );
+        TTEST( my_pa.space() == 1 );
+        TTEST( ! my_pa.fixed( "Modes" ) );
+        TTEST( my_pa.fixed( "Mode" ) );
+        TTEST( my_pa.is_get_char( ':' ) );
+        TTEST( my_pa.space() == 1 );
+        TTEST( my_pa.get_escaped_until( &bs, alphabet_char( ';' ), '\\' ) == 200002 );
+        TTEST( bs == std::string( 100000, 'b' ) + ';' + std::string( 100000, 'c' ) );
+        TTEST( my_pa.is_get_char( ';' ) );
+        TTEST( my_pa.get_reader().get_line_number() == 1 );
+        TTEST( my_pa.get_reader().get_column_number() == 300010 );
+        TTEST( my_pa.is_peek_at_end() );
+
+        TDOC( "Rewinding to locations that are and aren't still in the buffer" );
+        TSETUP( my_pa.location_top() );
+        TTEST( my_pa.get() == 'a' );
+        TTEST( my_pa.skip( alphabet_char( 'a' ), 65530 ) == 65530 );
+        TSETUP( my_pa.location_push() );
+        TTEST( my_pa.skip( alphabet_char( 'a' ) ) == 100000 - 65531 );
+        TTEST( my_pa.fixed( " Mode: bbb" ) );
+        TTEST( my_pa.location_top() );
+        TTEST( my_pa.skip( alphabet_char( 'a' ) ) == 100000 - 65531 );
+        TTEST( my_pa.fixed( " Mode: bbb" ) );
+        TSETUP( my_pa.location_pop() );
+        TSETUP( my_pa.location_top() );
+        TTEST( my_pa.skip( alphabet_char( 'a' ) ) == 100000 );
+        TTEST( my_pa.get_reader().get_column_number() == 100000 );
+    }
+}
+
 TFUNCTION( dsl_pa_fixed_test )
 {
     TBEGIN( "dsl pa fixed and ifixed tests" );
@@ -683,6 +768,166 @@ TFUNCTION( dsl_pa_fixed_test )
 
     TTEST( command == "MyMode" );
     }
+
+    {
+    // Long enough to be compared a block at a time
+    reader_string my_reader( "Content-Type: Text/HTML; @[`{\xC0\xE0 charset=UTF-8" );
+    dsl_pa my_pa( my_reader );
+
+    std::string header;
+
+    TTEST( ! my_pa.fixed( "Content-type: text/html;" ) );
+    TTEST( ! my_pa.ifixed( "content-type: text/htmx;" ) );
+    TTEST( ! my_pa.ifixed( "content-type: text/html; `@{[" ) );
+    TTEST( my_pa.fixed( "Content-Type: " ) );
+    TTEST( my_pa.get_ifixed( &header, "tEXT/html; @[`{" ) );
+    TTEST( header == "Text/HTML; @[`{" );
+    TTEST( ! my_pa.ifixed( "\xE0\xE0" ) );
+    TTEST( my_pa.ifixed( "\xC0\xE0 CHARSET=utf-8" ) );
+    TTEST( my_pa.is_peek_at_end() );
+    }
+
+    {
+    // Sought text longer than the remaining input
+    reader_string my_reader( "Mode" );
+    dsl_pa my_pa( my_reader );
+
+    TTEST( ! my_pa.fixed( "Modes" ) );
+    TTEST( ! my_pa.ifixed( "MODES" ) );
+    TTEST( ! my_pa.ifixed( "NODES" ) );
+    TTEST( my_pa.ifixed( "MODE" ) );
+    }
+}
+
+class reader_string_without_span : public reader_string
+{
+    // Forces dsl_pa to use its char at a time code paths
+public:
+    reader_string_without_span( const char * p_input_in ) : reader_string( p_input_in ) {}
+
+private:
+    virtual bool source_span( const char ** /*pp_begin*/, const char ** /*pp_end*/ ) { return false; }
+};
+
+template< class Treader >
+void dsl_pa_fixed_one_of_reader_test( const char * p_reader_name )
+{
+    TDOC( p_reader_name );
+
+    static const char * const methods[] = { "GET", "POST", "PUT", "PATCH", "DELETE", "POST" };
+    keyword_set http_methods( methods, sizeof( methods ) / sizeof( methods[0] ) );
+
+    TTEST( http_methods.size() == 6 );
+    TTEST( http_methods.keyword( 3 ) == "PATCH" );
+    TTEST( ! http_methods.is_case_insensitive() );
+
+    {
+    Treader my_reader( "PUT /index.html" );
+    dsl_pa my_pa( my_reader );
+
+    size_t index = 99;
+    TTEST( my_pa.fixed_one_of( http_methods, &index ) );
+    TTEST( index == 2 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    }
+
+    {
+    Treader my_reader( "PATCH" );
+    dsl_pa my_pa( my_reader );
+
+    std::string method( "old" );
+    size_t index = 99;
+    TTEST( my_pa.get_fixed_one_of( &method, http_methods, &index ) );
+    TTEST( method == "PATCH" );
+    TTEST( index == 3 );
+    TTEST( my_pa.is_peek_at_end() );
+    }
+
+    {
+    Treader my_reader( "POST" );
+    dsl_pa my_pa( my_reader );
+
+    size_t index = 99;
+    TTEST( my_pa.fixed_one_of( http_methods, &index ) );
+    TDOC( "Duplicate keyword gets the index of its first occurrence" );
+    TTEST( index == 1 );
+    }
+
+    {
+    Treader my_reader( "PAST" );
+    dsl_pa my_pa( my_reader );
+
+    size_t index = 99;
+    std::string method( "old" );
+    TTEST( ! my_pa.fixed_one_of( http_methods, &index ) );
+    TTEST( index == 99 );
+    TTEST( ! my_pa.get_fixed_one_of( &method, http_methods ) );
+    TTEST( method == "" );
+    TDOC( "Input unchanged on failure" );
+    TTEST( my_pa.fixed( "PAST" ) );
+    }
+
+    {
+    Treader my_reader( "get" );
+    dsl_pa my_pa( my_reader );
+
+    TTEST( ! my_pa.fixed_one_of( http_methods ) );
+    TTEST( my_pa.fixed( "get" ) );
+    }
+
+    {
+    // Longest match wins, and shorter matches are used when a longer
+    // keyword is only partially present
+    keyword_set sql_keywords( true );
+    sql_keywords.add( "in" ).add( "insert" ).add( "into" ).add( "is" );
+
+    TTEST( sql_keywords.is_case_insensitive() );
+
+    Treader my_reader( "INSERT Into iNsERx IS in" );
+    dsl_pa my_pa( my_reader );
+
+    std::string keyword;
+    size_t index = 99;
+    TTEST( my_pa.get_fixed_one_of( &keyword, sql_keywords, &index ) );
+    TTEST( keyword == "INSERT" );
+    TTEST( index == 1 );
+    TTEST( my_pa.space() );
+    TTEST( my_pa.get_fixed_one_of( &keyword, sql_keywords, &index ) );
+    TTEST( keyword == "Into" );
+    TTEST( index == 2 );
+    TTEST( my_pa.space() );
+    TTEST( my_pa.get_fixed_one_of( &keyword, sql_keywords, &index ) );
+    TTEST( keyword == "iN" );
+    TTEST( index == 0 );
+    TTEST( my_pa.fixed( "sERx" ) );
+    TTEST( my_pa.space() );
+    TTEST( my_pa.read_fixed_one_of( &keyword, sql_keywords, &index ) );
+    TTEST( keyword == "iNIS" );
+    TTEST( index == 3 );
+    TTEST( my_pa.space() );
+    TTEST( my_pa.fixed_one_of( sql_keywords, &index ) );
+    TTEST( index == 0 );
+    TTEST( my_pa.is_peek_at_end() );
+    }
+
+    {
+    keyword_set empty_set;
+
+    Treader my_reader( "GET" );
+    dsl_pa my_pa( my_reader );
+
+    TTEST( empty_set.empty() );
+    TTEST( ! my_pa.fixed_one_of( empty_set ) );
+    TTEST( my_pa.fixed( "GET" ) );
+    }
+}
+
+TFUNCTION( dsl_pa_fixed_one_of_test )
+{
+    TBEGIN( "dsl pa fixed_one_of tests" );
+
+    dsl_pa_fixed_one_of_reader_test< reader_string >( "reader_string" );
+    dsl_pa_fixed_one_of_reader_test< reader_string_without_span >( "reader_string_without_span" );
 }
 
 TFUNCTION( dsl_pa_get_char_test )
@@ -891,6 +1136,276 @@ TFUNCTION( dsl_pa_get_uint_test )
     dsl_pa_uint_test( "w", 0, 0 );
 }
 
+template< typename T, class Treader >
+void dsl_pa_integer_test( const char * p_input, T expected_value, size_t n_chars, bool is_overflow = false )
+{
+    TDOC( (std::string( "Input: " ) + p_input).c_str() );
+    Treader my_reader( p_input );
+    dsl_pa my_pa( my_reader );
+    T result = 0;
+    bool was_overflow = ! is_overflow;
+    TTEST( my_pa.get_integer( &result, &was_overflow ) == n_chars );
+    TTEST( was_overflow == is_overflow );
+    if( n_chars != 0 )
+        { TTEST( result == expected_value ); }
+    else
+        { TTEST( my_pa.get() == *p_input ); }   // Check input location rewound
+}
+
+template< class Treader >
+void dsl_pa_get_integer_reader_test( const char * p_reader_name )
+{
+    TDOC( p_reader_name );
+
+    dsl_pa_integer_test< signed char, Treader >( "127 ", 127, 3 );
+    dsl_pa_integer_test< signed char, Treader >( "-128 ", -128, 4 );
+    dsl_pa_integer_test< signed char, Treader >( "+12", 12, 3 );
+    dsl_pa_integer_test< signed char, Treader >( "128", 0, 0, true );
+    dsl_pa_integer_test< signed char, Treader >( "-129", 0, 0, true );
+    dsl_pa_integer_test< unsigned char, Treader >( "255", 255, 3 );
+    dsl_pa_integer_test< unsigned char, Treader >( "256", 0, 0, true );
+    dsl_pa_integer_test< unsigned char, Treader >( "-1", 0, 0 );
+    dsl_pa_integer_test< unsigned char, Treader >( "+1", 0, 0 );
+    dsl_pa_integer_test< short, Treader >( "-32768", -32768, 6 );
+    dsl_pa_integer_test< short, Treader >( "32768", 0, 0, true );
+    dsl_pa_integer_test< unsigned short, Treader >( "00065535x", 65535, 8 );
+    dsl_pa_integer_test< unsigned short, Treader >( "65536", 0, 0, true );
+    dsl_pa_integer_test< int, Treader >( "-2147483648", (std::numeric_limits< int >::min)(), 11 );
+    dsl_pa_integer_test< int, Treader >( "2147483647", 2147483647, 10 );
+    dsl_pa_integer_test< int, Treader >( "2147483648", 0, 0, true );
+    dsl_pa_integer_test< unsigned int, Treader >( "4294967295", 4294967295U, 10 );
+    dsl_pa_integer_test< unsigned int, Treader >( "4294967296", 0, 0, true );
+    dsl_pa_integer_test< int64, Treader >( "-9223372036854775808", (std::numeric_limits< int64 >::min)(), 20 );
+    dsl_pa_integer_test< int64, Treader >( "9223372036854775807", (std::numeric_limits< int64 >::max)(), 19 );
+    dsl_pa_integer_test< int64, Treader >( "9223372036854775808", 0, 0, true );
+    dsl_pa_integer_test< uint64, Treader >( "18446744073709551615", (std::numeric_limits< uint64 >::max)(), 20 );
+    dsl_pa_integer_test< uint64, Treader >( "18446744073709551616", 0, 0, true );
+    dsl_pa_integer_test< uint64, Treader >( "99999999999999999999999", 0, 0, true );
+    dsl_pa_integer_test< uint64, Treader >( "12345678123456781234 ", 12345678123456781234ULL, 20 );
+    dsl_pa_integer_test< uint64, Treader >( "1234567x12345678", 1234567, 7 );
+    dsl_pa_integer_test< int64, Treader >( "-0000000000000000000000000001", -1, 29 );
+    dsl_pa_integer_test< int, Treader >( "1234567890123456", 0, 0, true );
+    dsl_pa_integer_test< int, Treader >( "-0", 0, 2 );
+    // The following should fail
+    dsl_pa_integer_test< int, Treader >( "-", 0, 0 );
+    dsl_pa_integer_test< int, Treader >( "+", 0, 0 );
+    dsl_pa_integer_test< int, Treader >( "--0", 0, 0 );
+    dsl_pa_integer_test< int, Treader >( "", 0, 0 );
+    dsl_pa_integer_test< int, Treader >( "w", 0, 0 );
+}
+
+template< class Treader >
+void dsl_pa_get_fixed_width_uint_reader_test( const char * p_reader_name )
+{
+    TDOC( p_reader_name );
+
+    {
+    Treader my_reader( "20240105T0930" );
+    dsl_pa my_pa( my_reader );
+    int year = 0, month = 0, dom = 0;
+    unsigned char hour = 0, minute = 0;
+    TTEST( my_pa.get_fixed_width_uint( &year, 4 ) );
+    TTEST( year == 2024 );
+    TTEST( my_pa.get_fixed_width_uint( &month, 2 ) );
+    TTEST( month == 1 );
+    TTEST( my_pa.get_fixed_width_uint( &dom, 2 ) );
+    TTEST( dom == 5 );
+    TTEST( ! my_pa.get_fixed_width_uint( &hour, 2 ) );
+    TTEST( my_pa.is_get_char( 'T' ) );
+    TTEST( my_pa.get_fixed_width_uint( &hour, 2 ) );
+    TTEST( hour == 9 );
+    TTEST( ! my_pa.get_fixed_width_uint( &minute, 3 ) );
+    TTEST( my_pa.get_fixed_width_uint( &minute, 2 ) );
+    TTEST( minute == 30 );
+    }
+
+    {
+    Treader my_reader( "123456789012345678X 99999999999999999999 1234567a" );
+    dsl_pa my_pa( my_reader );
+    uint64 id = 0;
+    unsigned int small = 0;
+    TTEST( my_pa.get_fixed_width_uint( &id, 16 ) );
+    TTEST( id == 1234567890123456ULL );
+    TTEST( ! my_pa.get_fixed_width_uint( &id, 4 ) );
+    TTEST( my_pa.get_fixed_width_uint( &small, 2 ) );
+    TTEST( small == 78 );
+    TTEST( my_pa.fixed( "X " ) );
+    TDOC( "Overflow" );
+    TTEST( ! my_pa.get_fixed_width_uint( &small, 10 ) );
+    TTEST( ! my_pa.get_fixed_width_uint( &id, 20 ) );
+    TTEST( my_pa.get_fixed_width_uint( &id, 19 ) );
+    TTEST( id == 9999999999999999999ULL );
+    TTEST( my_pa.get_fixed_width_uint( &small, 1 ) );
+    TTEST( small == 9 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TDOC( "Non-digit within an eight char block" );
+    TTEST( ! my_pa.get_fixed_width_uint( &small, 8 ) );
+    TTEST( my_pa.get_fixed_width_uint( &small, 7 ) );
+    TTEST( small == 1234567 );
+    }
+}
+
+TFUNCTION( dsl_pa_get_fixed_width_uint_test )
+{
+    TBEGIN( "dsl_pa::get_fixed_width_uint() Tests" );
+
+    dsl_pa_get_fixed_width_uint_reader_test< reader_string >( "reader_string" );
+    dsl_pa_get_fixed_width_uint_reader_test< reader_string_without_span >( "reader_string_without_span" );
+}
+
+template< class Treader >
+void dsl_pa_get_hex_oct_bin_reader_test( const char * p_reader_name )
+{
+    TDOC( p_reader_name );
+
+    {
+    Treader my_reader( "1aF9 0123456789abcdefABCDEF01g deadBEEF12345678x ffffffffffffffff0 7fz" );
+    dsl_pa my_pa( my_reader );
+    unsigned int value = 0;
+    uint64 long_value = 0;
+    unsigned char small = 0;
+    TTEST( my_pa.get_hex( &value ) == 4 );
+    TTEST( value == 0x1af9 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TDOC( "Too many digits for the type" );
+    TTEST( my_pa.get_hex( &long_value ) == 0 );
+    TTEST( my_pa.get_hex( &long_value, 1, 16 ) == 16 );
+    TTEST( long_value == 0x0123456789abcdefULL );
+    TTEST( my_pa.get_hex( &value, 1, 4 ) == 4 );
+    TTEST( value == 0xabcd );
+    TTEST( my_pa.get_hex( &value ) == 4 );
+    TTEST( value == 0xef01 );
+    TTEST( my_pa.fixed( "g " ) );
+    TTEST( my_pa.get_hex( &long_value ) == 16 );
+    TTEST( long_value == 0xdeadbeef12345678ULL );
+    TTEST( my_pa.fixed( "x " ) );
+    TTEST( my_pa.get_hex( &long_value ) == 0 );
+    TTEST( my_pa.get_hex( &long_value, 17 ) == 0 );
+    TTEST( my_pa.get_hex( &long_value, 16, 16 ) == 16 );
+    TTEST( long_value == 0xffffffffffffffffULL );
+    TTEST( my_pa.get_hex( &small ) == 1 );
+    TTEST( small == 0 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TDOC( "Fewer than min_digits" );
+    TTEST( my_pa.get_hex( &small, 3 ) == 0 );
+    TTEST( my_pa.get_hex( &small, 2 ) == 2 );
+    TTEST( small == 0x7f );
+    TTEST( my_pa.get_hex( &small ) == 0 );
+    TTEST( my_pa.is_get_char( 'z' ) );
+    }
+
+    {
+    Treader my_reader( "0755 778 1010 1012 377 400" );
+    dsl_pa my_pa( my_reader );
+    int value = 0;
+    unsigned char small = 0;
+    TTEST( my_pa.get_oct( &value ) == 4 );
+    TTEST( value == 0755 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TTEST( my_pa.get_oct( &value ) == 2 );
+    TTEST( value == 077 );
+    TTEST( my_pa.fixed( "8 " ) );
+    TTEST( my_pa.get_bin( &value ) == 4 );
+    TTEST( value == 10 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TTEST( my_pa.get_bin( &value, 4 ) == 0 );
+    TTEST( my_pa.get_bin( &value ) == 3 );
+    TTEST( value == 5 );
+    TTEST( my_pa.fixed( "2 " ) );
+    TTEST( my_pa.get_oct( &small ) == 3 );
+    TTEST( small == 255 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TTEST( my_pa.get_oct( &small ) == 0 );
+    TTEST( my_pa.fixed( "400" ) );
+    }
+
+    {
+    TDOC( "Random hex strings" );
+    unsigned int seed = 1;
+    size_t n_different = 0;
+    static const char hex_chars[] = "0123456789abcdefABCDEF/:@G`g";
+    for( int i = 0; i < 2000; ++i )
+    {
+        std::string input;
+        uint64 expected = 0;
+        size_t n_expected = 0;
+        bool is_digits_ended = false;
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % 20;
+        for( size_t j = 0; j < length; ++j )
+        {
+            seed = seed * 1103515245 + 12345;
+            size_t index = (seed >> 16) % (i % 2 == 0 ? 22 : 28);
+            input.push_back( hex_chars[index] );
+            if( index >= 22 )
+                is_digits_ended = true;
+            if( ! is_digits_ended && n_expected < 16 )
+            {
+                expected = (expected << 4) + (index < 16 ? index : index - 6);
+                ++n_expected;
+            }
+        }
+        Treader my_reader( input.c_str() );
+        dsl_pa my_pa( my_reader );
+        uint64 value = 0;
+        size_t n_read = my_pa.get_hex( &value, 1, 16 );
+        if( n_read != n_expected || (n_read != 0 && value != expected) )
+            ++n_different;
+    }
+    TTEST( n_different == 0 );
+    }
+}
+
+TFUNCTION( dsl_pa_get_hex_oct_bin_test )
+{
+    TBEGIN( "dsl_pa::get_hex(), get_oct() and get_bin() Tests" );
+
+    dsl_pa_get_hex_oct_bin_reader_test< reader_string >( "reader_string" );
+    dsl_pa_get_hex_oct_bin_reader_test< reader_string_without_span >( "reader_string_without_span" );
+}
+
+TFUNCTION( dsl_pa_get_integer_test )
+{
+    TBEGIN( "dsl_pa::get_integer() Tests" );
+
+    dsl_pa_get_integer_reader_test< reader_string >( "reader_string" );
+    dsl_pa_get_integer_reader_test< reader_string_without_span >( "reader_string_without_span" );
+
+    {
+    TDOC( "Location unchanged after overflow" );
+    reader_string my_reader( "300,200" );
+    dsl_pa my_pa( my_reader );
+    unsigned char small = 0;
+    int large = 0;
+    TTEST( my_pa.get_integer( &small ) == 0 );
+    TTEST( my_pa.get_integer( &large ) == 3 );
+    TTEST( large == 300 );
+    TTEST( my_pa.is_get_char( ',' ) );
+    TTEST( my_pa.get_integer( &small ) == 3 );
+    TTEST( small == 200 );
+    }
+
+    {
+    TDOC( "get_int() and get_uint() leave location unchanged after overflow" );
+    reader_string my_reader( "99999999999,-99999999999,99999999999999999999" );
+    dsl_pa my_pa( my_reader );
+    int i = 12;
+    unsigned int u = 12;
+    TTEST( my_pa.get_int( &i ) == 0 );
+    TTEST( i == 12 );
+    TTEST( my_pa.peek() == '9' );
+    TTEST( my_pa.get_uint( &u ) == 11 );
+    TTEST( my_pa.is_get_char( ',' ) );
+    TTEST( my_pa.get_int( &i ) == 0 );
+    TTEST( i == 12 );
+    TTEST( my_pa.peek() == '-' );
+    TTEST( my_pa.skip( alphabet_not( alphabet_char( ',' ) ) ) == 12 );
+    TTEST( my_pa.is_get_char( ',' ) );
+    TTEST( my_pa.get_uint( &u ) == 0 );
+    TTEST( my_pa.peek() == '9' );
+    }
+}
+
 void dsl_pa_float_test( const char * p_input, float expected_value, bool is_valid )
 {
     TDOC( (std::string( "Input: " ) + p_input).c_str() );
@@ -968,6 +1483,92 @@ TFUNCTION( dsl_pa_get_sci_float_test )
     dsl_pa_sci_float_test( "w", 0.0f, false, 'w' );
 }
 
+template< class Treader >
+bool is_sci_float_same_as_strtod( const std::string & r_input )
+{
+    Treader my_reader( r_input.c_str() );
+    dsl_pa my_pa( my_reader );
+    double result = 0;
+    if( ! my_pa.get_sci_float( &result ) )
+        return false;
+    double expected = strtod( r_input.c_str(), 0 );
+    return memcmp( &result, &expected, sizeof( double ) ) == 0;
+}
+
+template< class Treader >
+void dsl_pa_get_float_exact_reader_test( const char * p_reader_name )
+{
+    TDOC( p_reader_name );
+
+    static const char * const hard_cases[] = {
+            "0.1", "1e23", "9007199254740993", "9007199254740992.5",
+            "2.2250738585072011e-308", "2.2250738585072014e-308",
+            "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+            "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308",
+            "1e400", "-1e400", "1e-400", "-0", "-0.0e5", "0e999999999",
+            "123456789012345678901234567890", "0.000000000000000000000000000001",
+            "7.038531e-26", "3.4028236692093846346e38", "1.00000000000000011102230246251565404236316680908203125",
+            "1.00000000000000011102230246251565404236316680908203124",
+            "1.00000000000000011102230246251565404236316680908203126",
+            "9214843084008499", "30078505129381147446200", "1777820000000000000001",
+            "0.3932922657273", "5.e-1", "1..5", "-2...5e3", ".5e1", "00000.00001e5" };
+
+    for( size_t i = 0; i < sizeof( hard_cases ) / sizeof( hard_cases[0] ); ++i )
+    {
+        TDOC( hard_cases[i] );
+        TTEST( is_sci_float_same_as_strtod< Treader >( hard_cases[i] ) );
+    }
+
+    unsigned int seed = 1;
+    size_t n_different = 0;
+    for( int i = 0; i < 20000; ++i )
+    {
+        std::string input;
+        seed = seed * 1103515245 + 12345;
+        size_t n_digits = 1 + (seed >> 16) % 25;
+        for( size_t j = 0; j < n_digits; ++j )
+        {
+            seed = seed * 1103515245 + 12345;
+            input.push_back( static_cast< char >( '0' + (seed >> 16) % 10 ) );
+        }
+        seed = seed * 1103515245 + 12345;
+        input.insert( (seed >> 16) % (n_digits + 1), "." );
+        seed = seed * 1103515245 + 12345;
+        int exponent = static_cast< int >( (seed >> 16) % 660 ) - 340;
+        std::ostringstream exponent_text;
+        exponent_text << 'e' << exponent;
+        input += exponent_text.str();
+        if( ! is_sci_float_same_as_strtod< Treader >( input ) )
+            ++n_different;
+    }
+    TDOC( "Random values" );
+    TTEST( n_different == 0 );
+}
+
+TFUNCTION( dsl_pa_get_float_exact_test )
+{
+    TBEGIN( "dsl_pa::get_sci_float() matches strtod() Tests" );
+
+    dsl_pa_get_float_exact_reader_test< reader_string >( "reader_string" );
+    dsl_pa_get_float_exact_reader_test< reader_string_without_span >( "reader_string_without_span" );
+
+    {
+    TDOC( "Multiple points are read, but strtod() ignores everything after the second" );
+    reader_string my_reader( "1..5e3 -..5 1.5e+x" );
+    dsl_pa my_pa( my_reader );
+    double result = 0;
+    TTEST( my_pa.get_sci_float( &result ) );
+    TTEST( result == 1.0 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TTEST( my_pa.get_sci_float( &result ) );
+    TTEST( result == 0.0 );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TTEST( my_pa.get_sci_float( &result ) );
+    TTEST( result == 1.5 );
+    TTEST( my_pa.fixed( "e+x" ) );
+    }
+}
+
 void dsl_pa_qstring_test( std::string input, const std::string & r_expected_value, bool is_valid )
 {
     input += '"';
@@ -1123,6 +1724,187 @@ TFUNCTION( dsl_pa_get_qstring_contents_test )
     TCALL( dsl_pa_single_quoted_qstring_test( "a\xdfz", "", false ) );            // Too short
 }
 
+template< class Treader >
+void dsl_pa_long_qstring_test( const std::string & r_input, const std::string & r_expected_value, bool is_valid )
+{
+    std::string input( r_input + "\"x" );
+    Treader my_reader( input.c_str() );
+    dsl_pa my_pa( my_reader );
+    std::string result;
+    TTEST( my_pa.get_qstring_contents( &result ) == is_valid );
+    if( is_valid )
+    {
+        TTEST( result == r_expected_value );
+        TTEST( my_pa.fixed( "\"x" ) );
+    }
+    else
+    {
+        TTEST( my_pa.get() == r_input[0] );   // Check input location rewound
+    }
+}
+
+TFUNCTION( dsl_pa_get_long_qstring_contents_test )
+{
+    TBEGIN( "dsl_pa::get_qstring_contents() with long plain runs Tests" );
+
+    // Place each kind of special char at every offset within a run long
+    // enough to span several blocks
+    const std::string plain( "The quick brown fox jumps over the lazy dog, 0123456789 ~!@#$%^&*()_+{}|:<>?" );
+
+    static const char * const specials[][2] = {
+            { "\\n", "\n" }, { "\\\"", "\"" }, { "\\u00e9", "\xc3\xa9" },
+            { "\xc3\xa9", "\xc3\xa9" }, { "\t", "\t" }, { "\x7f", "\x7f" } };
+
+    for( size_t i = 0; i < sizeof( specials ) / sizeof( specials[0] ); ++i )
+    {
+        TDOC( specials[i][0] );
+        size_t n_wrong = 0;
+        for( size_t offset = 0; offset <= plain.size(); ++offset )
+        {
+            std::string input = plain.substr( 0, offset ) + specials[i][0] + plain.substr( offset ) + "\"";
+            std::string expected = plain.substr( 0, offset ) + specials[i][1] + plain.substr( offset );
+            reader_string my_reader( input );
+            dsl_pa my_pa( my_reader );
+            std::string result;
+            if( ! my_pa.get_qstring_contents( &result ) || result != expected || ! my_pa.is_get_char( '"' ) )
+                ++n_wrong;
+        }
+        TTEST( n_wrong == 0 );
+    }
+
+    std::string long_plain;
+    for( int i = 0; i < 20; ++i )
+        long_plain += plain;
+
+    TCALL( dsl_pa_long_qstring_test< reader_string >( long_plain, long_plain, true ) );
+    TCALL( dsl_pa_long_qstring_test< reader_string_without_span >( long_plain, long_plain, true ) );
+    TCALL( dsl_pa_long_qstring_test< reader_string >( long_plain + "\\q" + long_plain, "", false ) );
+    TCALL( dsl_pa_long_qstring_test< reader_string >( long_plain + "\xc3" + long_plain, "", false ) );
+    TCALL( dsl_pa_long_qstring_test< reader_string >( long_plain + "\\\\" + long_plain, long_plain + "\\" + long_plain, true ) );
+}
+
+bool is_rfc3629_utf8( const std::string & r_sequence )
+{
+    // A direct transcription of the RFC 3629 grammar to check the parser against
+    size_t i = 0;
+    while( i < r_sequence.size() )
+    {
+        unsigned char c = static_cast<unsigned char>( r_sequence[i] );
+        size_t n_tail = 0;
+        unsigned char min_second = 0x80, max_second = 0xbf;
+        if( c < 0x80 )
+            n_tail = 0;
+        else if( c >= 0xc2 && c <= 0xdf )
+            n_tail = 1;
+        else if( c == 0xe0 )
+            n_tail = 2, min_second = 0xa0;
+        else if( (c >= 0xe1 && c <= 0xec) || c == 0xee || c == 0xef )
+            n_tail = 2;
+        else if( c == 0xed )
+            n_tail = 2, max_second = 0x9f;
+        else if( c == 0xf0 )
+            n_tail = 3, min_second = 0x90;
+        else if( c >= 0xf1 && c <= 0xf3 )
+            n_tail = 3;
+        else if( c == 0xf4 )
+            n_tail = 3, max_second = 0x8f;
+        else
+            return false;
+        ++i;
+        for( size_t j = 0; j < n_tail; ++j, ++i )
+        {
+            if( i >= r_sequence.size() )
+                return false;
+            unsigned char t = static_cast<unsigned char>( r_sequence[i] );
+            if( t < (j == 0 ? min_second : 0x80) || t > (j == 0 ? max_second : 0xbf) )
+                return false;
+        }
+    }
+    return true;
+}
+
+template< class Treader >
+size_t dsl_pa_utf8_mismatches( const std::string & r_sequence )
+{
+    std::string input( "a" + r_sequence + "z\"" );
+    Treader my_reader( input.c_str() );
+    dsl_pa my_pa( my_reader );
+    std::string result;
+    bool is_valid = is_rfc3629_utf8( r_sequence );
+    if( my_pa.get_qstring_contents( &result ) != is_valid )
+        return 1;
+    if( is_valid )
+        return (result == "a" + r_sequence + "z" && my_pa.is_get_char( '"' )) ? 0 : 1;
+    return my_pa.get() == 'a' ? 0 : 1;
+}
+
+TFUNCTION( dsl_pa_get_qstring_contents_utf8_test )
+{
+    TBEGIN( "dsl_pa::get_qstring_contents() UTF-8 validation Tests" );
+
+    {
+    TDOC( "Every lead byte followed by boundary continuation bytes" );
+    static const unsigned char seconds[] = { 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0 };
+    static const unsigned char tails[] = { 0x7f, 0x80, 0xbf, 0xc0 };
+    size_t n_sequences = 0;
+    size_t n_wrong = 0;
+    size_t n_wrong_without_span = 0;
+    for( unsigned lead = 0x80; lead <= 0xff; ++lead )
+        for( size_t s = 0; s < sizeof( seconds ); ++s )
+            for( size_t t1 = 0; t1 <= sizeof( tails ); ++t1 )
+                for( size_t t2 = 0; t2 <= sizeof( tails ); ++t2 )
+                {
+                    // t == sizeof( tails ) means 'no further byte'
+                    std::string sequence;
+                    sequence += static_cast<char>( lead );
+                    sequence += static_cast<char>( seconds[s] );
+                    if( t1 < sizeof( tails ) )
+                        sequence += static_cast<char>( tails[t1] );
+                    else if( t2 < sizeof( tails ) )
+                        continue;
+                    if( t2 < sizeof( tails ) )
+                        sequence += static_cast<char>( tails[t2] );
+                    ++n_sequences;
+                    n_wrong += dsl_pa_utf8_mismatches< reader_string >( sequence );
+                    n_wrong_without_span += dsl_pa_utf8_mismatches< reader_string_without_span >( sequence );
+                }
+    TTEST( n_sequences > 3000 );
+    TTEST( n_wrong == 0 );
+    TTEST( n_wrong_without_span == 0 );
+    }
+
+    {
+    TDOC( "Mixed text, escapes and multibyte chars" );
+    std::string input( "na\xc3\xafve caf\xc3\xa9 \\u00e9 \xe6\x97\xa5\xe6\x9c\xac\\n\xf0\x9f\x98\x80!\"" );
+    std::string expected( "na\xc3\xafve caf\xc3\xa9 \xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac\n\xf0\x9f\x98\x80!" );
+    {
+    reader_string my_reader( input );
+    dsl_pa my_pa( my_reader );
+    std::string result;
+    TTEST( my_pa.get_qstring_contents( &result ) );
+    TTEST( result == expected );
+    TTEST( my_pa.is_get_char( '"' ) );
+    }
+    {
+    reader_string_without_span my_reader( input.c_str() );
+    dsl_pa my_pa( my_reader );
+    std::string result;
+    TTEST( my_pa.get_qstring_contents( &result ) );
+    TTEST( result == expected );
+    TTEST( my_pa.is_get_char( '"' ) );
+    }
+    }
+
+    {
+    TDOC( "Truncated multibyte char at end of input" );
+    reader_string my_reader( "ab\xe6\x97" );
+    dsl_pa my_pa( my_reader );
+    std::string result;
+    TTEST( my_pa.get_qstring_contents( &result ) == false );
+    TTEST( my_pa.get() == 'a' );
+    }
+}
+
 TFUNCTION( dsl_pa_get_unterminated_qstring_contents_test )
 {
     TBEGIN( "Unterminated dsl_pa::get_qstring_contents() Tests" );
@@ -1153,6 +1935,260 @@ TFUNCTION( dsl_pa_get_unterminated_qstring_contents_test )
     }
 }
 
+template< class Treader >
+void dsl_pa_get_string_ref_reader_test( const char * p_reader_name, bool is_in_place )
+{
+    TDOC( p_reader_name );
+
+    {
+    Treader my_reader( "abc12 xyz" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get( &result, alphabet_alpha() ) == 3 );
+    TTEST( result == "abc" );
+    TTEST( result.is_in_place() == is_in_place );
+    TTEST( my_pa.get( &result, alphabet_digit(), 1 ) == 1 );
+    TTEST( result == "1" );
+    TTEST( my_pa.get( &result, alphabet_alpha() ) == 0 );
+    TTEST( result.empty() );
+    TTEST( my_pa.get_until( &result, alphabet_space() ) == 1 );
+    TTEST( result == "2" );
+    TTEST( my_pa.is_get_char( ' ' ) );
+    TTEST( my_pa.get_bounded_until( &result, alphabet_space(), 2 ) == 2 );
+    TTEST( result == "xy" );
+    TTEST( my_pa.get_until( &result, alphabet_space() ) == 1 );
+    TTEST( result == std::string( "z" ) );
+    TTEST( my_pa.get( &result, alphabet_alpha() ) == 0 );
+    TTEST( result == "" );
+    }
+
+    {
+    Treader my_reader( "plain\" x" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) );
+    TTEST( result == "plain" );
+    TTEST( result.is_in_place() == is_in_place );
+    TTEST( my_pa.fixed( "\" x" ) );
+    }
+
+    {
+    Treader my_reader( "\" x" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) );
+    TTEST( result.empty() );
+    TTEST( my_pa.fixed( "\" x" ) );
+    }
+
+    {
+    Treader my_reader( "caf\xc3\xa9 \\u00e9 \\\"q\\\"\" x" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) );
+    TTEST( result == "caf\xc3\xa9 \xc3\xa9 \"q\"" );
+    TTEST( ! result.is_in_place() );
+    TTEST( my_pa.fixed( "\" x" ) );
+    }
+
+    {
+    Treader my_reader( "ab\xc3z\" x" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) == false );
+    TTEST( my_pa.get() == 'a' );    // Check input location rewound
+    }
+
+    {
+    Treader my_reader( "ab\\q\" x" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) == false );
+    TTEST( my_pa.get() == 'a' );
+    }
+
+    {
+    Treader my_reader( "abc" );     // No terminating "
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) == false );
+    TTEST( my_pa.get() == 'a' );
+    }
+}
+
+TFUNCTION( dsl_pa_get_string_ref_test )
+{
+    TBEGIN( "dsl_pa::get...( string_ref * ) Tests" );
+
+    dsl_pa_get_string_ref_reader_test< reader_string >( "reader_string", true );
+    dsl_pa_get_string_ref_reader_test< reader_string_without_span >( "reader_string_without_span", false );
+
+    {
+    TDOC( "string_ref refers into the input" );
+    const char * p_input = "token rest";
+    reader_string my_reader( p_input );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get( &result, alphabet_alpha() ) == 5 );
+    TTEST( result.data() == p_input );
+    TTEST( result.size() == 5 );
+    TTEST( result.str() == "token" );
+    string_ref copy( result );
+    TTEST( copy == result );
+    TTEST( copy != "rest" );
+    }
+
+    {
+    TDOC( "Buffered string_ref survives being copied" );
+    reader_string my_reader( "a\\tb\"" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents( &result ) );
+    string_ref copy;
+    copy = result;
+    result.clear();
+    TTEST( result.empty() );
+    TTEST( copy == "a\tb" );
+    TTEST( copy[1] == '\t' );
+    }
+}
+
+TFUNCTION( dsl_pa_get_in_place_test )
+{
+    TBEGIN( "dsl_pa::get..._in_place() Tests" );
+
+    {
+    TDOC( "Escaped q-string is unescaped into the input" );
+    char input[] = "caf\xc3\xa9 \\u00e9 \\\"q\\\" \\uD800\\uDC02!\" x";
+    reader_mutable_mem_buf my_reader( input, strlen( input ) );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents_in_place( &result ) );
+    TTEST( result == "caf\xc3\xa9 \xc3\xa9 \"q\" \xF0\x90\x80\x82!" );
+    TTEST( result.is_in_place() );
+    TTEST( result.data() == input );
+    TTEST( my_pa.fixed( "\" x" ) );
+    }
+
+    {
+    TDOC( "Unescaped q-string is referred to without being modified" );
+    char input[] = "plain\"";
+    reader_mutable_mem_buf my_reader( input, strlen( input ) );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents_in_place( &result ) );
+    TTEST( result == "plain" );
+    TTEST( result.data() == input );
+    TTEST( my_pa.is_get_char( '"' ) );
+    }
+
+    {
+    TDOC( "Invalid q-string leaves input unmodified" );
+    char input[] = "a\\tb\\q\"";
+    const std::string original( input );
+    reader_mutable_mem_buf my_reader( input, strlen( input ) );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents_in_place( &result ) == false );
+    TTEST( original == input );
+    TTEST( my_pa.get() == 'a' );    // Check input location rewound
+    }
+
+    {
+    TDOC( "Successive q-strings" );
+    std::vector< char > input;
+    const char * p_json = "[\"a\\nb\",\"\\u0041\",\"c\"]";
+    input.assign( p_json, p_json + strlen( p_json ) );
+    reader_mutable_mem_buf my_reader( input );
+    dsl_pa my_pa( my_reader );
+    string_ref first, second, third;
+    TTEST( my_pa.fixed( "[\"" ) );
+    TTEST( my_pa.get_qstring_contents_in_place( &first ) );
+    TTEST( my_pa.fixed( "\",\"" ) );
+    TTEST( my_pa.get_qstring_contents_in_place( &second ) );
+    TTEST( my_pa.fixed( "\",\"" ) );
+    TTEST( my_pa.get_qstring_contents_in_place( &third ) );
+    TTEST( my_pa.fixed( "\"]" ) );
+    TTEST( first == "a\nb" );
+    TTEST( second == "A" );
+    TTEST( third == "c" );
+    }
+
+    {
+    TDOC( "Readers that can't be modified use a buffer" );
+    reader_string my_reader( "a\\tb\" x" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents_in_place( &result ) );
+    TTEST( result == "a\tb" );
+    TTEST( ! result.is_in_place() );
+    TTEST( my_pa.fixed( "\" x" ) );
+    }
+
+    {
+    TDOC( "get_escaped_until_in_place()" );
+    char input[] = "a\\,b\\\\c\\d,e";
+    reader_mutable_mem_buf my_reader( input, strlen( input ) );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_escaped_until_in_place( &result, alphabet_char( ',' ), '\\' ) == 9 );
+    TTEST( result == "a,b\\\\c\\d" );    // An escape char that doesn't escape a sought char is kept
+    TTEST( result.data() == input );
+    TTEST( my_pa.is_get_char( ',' ) );
+    TTEST( my_pa.get_escaped_until_in_place( &result, alphabet_char( ',' ), '\\' ) == 1 );
+    TTEST( result == "e" );
+    }
+
+    {
+    TDOC( "In-place q-string with lazy line counting" );
+    char input[] = "a\\nb\"x";
+    reader_mutable_mem_buf my_reader( input, strlen( input ) );
+    TTEST( my_reader.set_lazy_line_counting( true ) );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_qstring_contents_in_place( &result ) );
+    TTEST( result == "a\nb" );
+    reader_string my_unmodified_reader( "a\\nb\"x" );
+    TTEST( my_unmodified_reader.set_lazy_line_counting( true ) );
+    dsl_pa my_unmodified_pa( my_unmodified_reader );
+    TTEST( my_unmodified_pa.get_qstring_contents( &result ) );
+    TTEST( my_reader.get_line_number() == 1 );
+    TTEST( my_reader.get_column_number() == my_unmodified_reader.get_column_number() );
+    }
+
+    {
+    TDOC( "get_escaped_until_in_place() with lazy line counting" );
+    char input[] = "\\|a\n|x";
+    reader_mutable_mem_buf my_reader( input, strlen( input ) );
+    TTEST( my_reader.set_lazy_line_counting( true ) );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    TTEST( my_pa.get_escaped_until_in_place( &result, alphabet_char( '|' ), '\\' ) == 4 );
+    TTEST( result == "|a\n" );
+    reader_string my_unmodified_reader( "\\|a\n|x" );
+    TTEST( my_unmodified_reader.set_lazy_line_counting( true ) );
+    dsl_pa my_unmodified_pa( my_unmodified_reader );
+    TTEST( my_unmodified_pa.get_escaped_until_in_place( &result, alphabet_char( '|' ), '\\' ) == 4 );
+    TTEST( my_reader.get_line_number() == 2 );
+    TTEST( my_reader.get_line_number() == my_unmodified_reader.get_line_number() );
+    TTEST( my_reader.get_column_number() == my_unmodified_reader.get_column_number() );
+    }
+
+    {
+    TDOC( "get_escaped_until_in_place() with a reader that can't be modified" );
+    reader_string my_reader( "a\\,b,c" );
+    dsl_pa my_pa( my_reader );
+    string_ref result;
+    std::string expected;
+    reader_string my_expected_reader( "a\\,b,c" );
+    dsl_pa my_expected_pa( my_expected_reader );
+    size_t n_expected = my_expected_pa.get_escaped_until( &expected, alphabet_char( ',' ), '\\' );
+    TTEST( my_pa.get_escaped_until_in_place( &result, alphabet_char( ',' ), '\\' ) == n_expected );
+    TTEST( result == expected );
+    TTEST( ! result.is_in_place() );
+    }
+}
+
 TFUNCTION( dsl_pa_current_is_test )
 {
     TBEGIN( "dsl_pa::current_is() Tests" );
@@ -1831,6 +2867,77 @@ TFUNCTION( accumulator_check )
     TTEST( collected_uint64 == 101 );
     }
 
+    {
+    TDOC( "Accumulators can return a large and negative value converted to int64" );
+    std::string in( "-9223372036854775808 18446744073709551615" );
+
+    reader_string my_reader( in );
+    dsl_pa my_pa( my_reader );
+    {
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate( alphabet_char( '-' ) );
+    my_pa.accumulate_all( alphabet_digit() );
+    TTEST( my_accumulator.to_int64() == (std::numeric_limits< int64 >::min)() );
+    }
+    my_pa.space();
+    {
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate_all( alphabet_digit() );
+    TTEST( my_accumulator.to_uint64() == (std::numeric_limits< uint64 >::max)() );
+    }
+    }
+
+    {
+    TDOC( "Accumulated integers that don't fit in int64 or uint64 are rejected" );
+    std::string in( "9223372036854775808 -9223372036854775809 18446744073709551616 -5" );
+
+    reader_string my_reader( in );
+    dsl_pa my_pa( my_reader );
+    {
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate_all( alphabet_digit() );
+    int64 collected_int64 = 7;
+    TTEST( ! my_accumulator.put_in( collected_int64 ) );
+    TTEST( collected_int64 == 7 );
+    TTEST( my_accumulator.to_int64() == 0 );
+    uint64 collected_uint64 = 7;
+    TTEST( my_accumulator.put_in( collected_uint64 ) );
+    TTEST( collected_uint64 == 9223372036854775808ULL );
+    }
+    my_pa.space();
+    {
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate( alphabet_char( '-' ) );
+    my_pa.accumulate_all( alphabet_digit() );
+    int64 collected_int64 = 7;
+    TTEST( ! my_accumulator.to_int64( &collected_int64 ) );
+    TTEST( collected_int64 == 7 );
+    }
+    my_pa.space();
+    {
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate_all( alphabet_digit() );
+    uint64 collected_uint64 = 7;
+    TTEST( ! my_accumulator.put_in( collected_uint64 ) );
+    TTEST( collected_uint64 == 7 );
+    TTEST( my_accumulator.to_uint64() == 0 );
+    }
+    my_pa.space();
+    {
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate( alphabet_char( '-' ) );
+    my_pa.accumulate_all( alphabet_digit() );
+    TTEST( my_accumulator.get() == "-5" );
+    uint64 collected_uint64 = 7;
+    TTEST( ! my_accumulator.put_in( collected_uint64 ) );
+    TTEST( collected_uint64 == 7 );
+    TTEST( my_accumulator.to_uint64() == 0 );
+    int64 collected_int64 = 0;
+    TTEST( my_accumulator.put_in( collected_int64 ) );
+    TTEST( collected_int64 == -5 );
+    }
+    }
+
     {
     TDOC( "Accumulators can return a value converted to float/double" );
     std::string in( "101.5" );
@@ -1848,3 +2955,118 @@ TFUNCTION( accumulator_check )
     TTEST( collected_double == 101.5 );
     }
 }
+
+template< class Treader >
+void accumulator_span_reader_check( const char * p_reader_name )
+{
+    TDOC( p_reader_name );
+
+    {
+    TDOC( "Chars accumulated from the input can be mixed with appended chars" );
+    Treader my_reader( "AB12CD" );
+    dsl_pa my_pa( my_reader );
+    accumulator my_accumulator( &my_pa );
+    TTEST( my_pa.accumulate( 'A' ) );
+    TTEST( my_pa.accumulate( alphabet_alpha() ) );
+    TTEST( my_pa.accumulator_append( '-' ) );
+    TTEST( my_pa.accumulate_all( alphabet_digit() ) == 2 );
+    TTEST( my_accumulator.get() == "AB-12" );
+    TTEST( my_pa.accumulate_all( alphabet_alpha() ) == 2 );
+    TTEST( my_accumulator.get() == "AB-12CD" );
+    TTEST( my_pa.is_peek_at_end() );
+    }
+
+    {
+    TDOC( "accumulate_all() with no accumulator selected skips the chars" );
+    Treader my_reader( "12345AB" );
+    dsl_pa my_pa( my_reader );
+    accumulator my_accumulator( &my_pa );
+    my_accumulator.none();
+    TTEST( my_pa.accumulate_all( alphabet_digit() ) == 5 );
+    TTEST( my_pa.peek() == 'A' );
+    my_accumulator.select();
+    TTEST( my_pa.accumulate_all( alphabet_alpha() ) == 2 );
+    TTEST( my_accumulator.get() == "AB" );
+    }
+
+    {
+    TDOC( "A failed accumulate() leaves current() as before" );
+    Treader my_reader( "AZ" );
+    dsl_pa my_pa( my_reader );
+    accumulator my_accumulator( &my_pa );
+    TTEST( my_pa.accumulate( 'A' ) );
+    TTEST( my_pa.current() == 'A' );
+    TTEST( ! my_pa.accumulate( 'B' ) );
+    TTEST( my_pa.current() == 'Z' );
+    TTEST( ! my_pa.accumulate( alphabet_digit() ) );
+    TTEST( my_pa.current() == 'Z' );
+    TTEST( my_accumulator.get() == "A" );
+    }
+
+    {
+    TDOC( "Nested accumulators append to previous" );
+    Treader my_reader( "abc123def456" );
+    dsl_pa my_pa( my_reader );
+    accumulator outer( &my_pa );
+    {
+    accumulator inner( &my_pa );
+    TTEST( my_pa.accumulate_all( alphabet_alpha() ) == 3 );
+    TTEST( my_pa.accumulator_to_previous() );
+    }
+    my_pa.accumulate_all( alphabet_digit() );
+    {
+    accumulator inner( &my_pa );
+    TTEST( my_pa.accumulate_all( alphabet_alpha() ) == 3 );
+    TTEST( inner.get() == "def" );
+    TTEST( my_pa.accumulate_atomic( true ) );
+    }
+    {
+    accumulator inner( &my_pa );
+    TTEST( my_pa.accumulate_all( alphabet_digit() ) == 3 );
+    TTEST( ! my_pa.accumulate_atomic( false ) );
+    TTEST( inner.get() == "" );
+    }
+    TTEST( outer.get() == "abc123def" );
+    std::string copy;
+    TTEST( outer.put_in( copy ) );
+    TTEST( copy == "abc123def" );
+    }
+
+    {
+    TDOC( "Accumulators can be appended to themselves and cleared" );
+    Treader my_reader( "xy12" );
+    dsl_pa my_pa( my_reader );
+    accumulator my_accumulator( &my_pa );
+    my_pa.accumulate_all( alphabet_alpha() );
+    TTEST( my_pa.accumulator_append( my_accumulator ) );
+    TTEST( my_accumulator.get() == "xyxy" );
+    TTEST( my_accumulator.clear() );
+    my_pa.accumulate_all( alphabet_digit() );
+    TTEST( my_accumulator.get() == "12" );
+    TTEST( my_accumulator.to_int() == 12 );
+    TTEST( my_accumulator.to_int64() == 12 );
+    }
+
+    {
+    TDOC( "Accumulated input after rewinding" );
+    Treader my_reader( "abcd" );
+    dsl_pa my_pa( my_reader );
+    accumulator my_accumulator( &my_pa );
+    {
+    locator loc( my_pa );
+    TTEST( my_pa.accumulate( 'a' ) );
+    TTEST( my_pa.accumulate( 'b' ) );
+    TTEST( my_pa.location_top() );
+    }
+    TTEST( my_pa.accumulate_all( alphabet_alpha() ) == 4 );
+    TTEST( my_accumulator.get() == "ababcd" );
+    }
+}
+
+TFUNCTION( accumulator_span_check )
+{
+    TBEGIN( "accumulator input span test" );
+
+    accumulator_span_reader_check< reader_string >( "reader_string" );
+    accumulator_span_reader_check< reader_string_without_span >( "reader_string_without_span" );
+}
@@ -35,6 +35,22 @@
 
 #include "dsl-pa/dsl-pa.h"
 
+#include <fcntl.h>
+#if defined( _WIN32 )
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+static int open_test_fd( const char * p_file_name )
+{
+#if defined( _WIN32 )
+    return _open( p_file_name, _O_RDONLY | _O_BINARY );
+#else
+    return open( p_file_name, O_RDONLY );
+#endif
+}
+
 using namespace cl;
 
 class reader_factory
@@ -96,6 +112,61 @@ public:
     }
 };
 
+class reader_factory_mmap : public reader_factory
+{
+public:
+    virtual reader * create( const char * p_data ) const
+    {
+        // Alternate between files so that a reader created earlier in a test
+        // doesn't have its mapped file truncated beneath it
+        static int file_index = 0;
+        const char * p_test_data_file_name = (++file_index % 2) ? "FoxdfEr43Dg.txt" : "FoxdfEr43Dh.txt";
+
+        {
+        std::ofstream fout( p_test_data_file_name, std::ios::binary );
+
+        TTEST( fout.is_open() );
+
+        if( ! fout.is_open() )
+            return 0;
+
+        fout << p_data;
+        }
+
+        return new reader_mmap( p_test_data_file_name );
+    }
+    virtual const char * form_name() const
+    {
+        return "Mmap";
+    }
+};
+
+class reader_factory_fd : public reader_factory
+{
+public:
+    virtual reader * create( const char * p_data ) const
+    {
+        const char * p_test_data_file_name = "FoxdfEr43Di.txt";
+
+        {
+        std::ofstream fout( p_test_data_file_name, std::ios::binary );
+
+        TTEST( fout.is_open() );
+
+        if( ! fout.is_open() )
+            return 0;
+
+        fout << p_data;
+        }
+
+        return new reader_fd( open_test_fd( p_test_data_file_name ), true );
+    }
+    virtual const char * form_name() const
+    {
+        return "Fd";
+    }
+};
+
 void reader_basic_test( reader_factory & r_reader_factory )
 {
     TBEGIN( (std::string( r_reader_factory.form_name() ) + " reader basic tests").c_str() );
@@ -319,6 +390,105 @@ void reader_location_and_unget_test( reader_factory & r_reader_factory )
     }
 }
 
+void reader_location_frame_test( reader_factory & r_reader_factory )
+{
+    TBEGIN( (std::string( r_reader_factory.form_name() ) + " reader location frame tests").c_str() );
+
+    {
+    TSETUP( std::auto_ptr< reader > p_reader( r_reader_factory.create( "ab\ncd" ) ) );
+    TCRITICALTEST( p_reader.get() != 0 );
+
+    TDOC( "Ungot chars that differ from the input are restored by location_top()" );
+    TTEST( p_reader->get() == 'a' );
+    TTEST( p_reader->get() == 'b' );
+    TSETUP( p_reader->unget( 'y' ) );
+    TSETUP( p_reader->unget( 'x' ) );
+    TSETUP( p_reader->location_push() );
+    TTEST( p_reader->get() == 'x' );
+    TSETUP( p_reader->location_push() );
+    TTEST( p_reader->get() == 'y' );
+    TTEST( p_reader->get() == '\n' );
+    TTEST( p_reader->location_top() );
+    TTEST( p_reader->get() == 'y' );
+    TSETUP( p_reader->location_pop() );
+    TTEST( p_reader->location_top() );
+    TTEST( p_reader->get() == 'x' );
+    TTEST( p_reader->get() == 'y' );
+    TSETUP( p_reader->location_revise() );
+    TTEST( p_reader->get() == '\n' );
+    TTEST( p_reader->get_line_number() == 2 );
+    TTEST( p_reader->location_top() );
+    TTEST( p_reader->get_line_number() == 1 );
+    TTEST( p_reader->get() == '\n' );
+    TTEST( p_reader->get() == 'c' );
+    TSETUP( p_reader->location_pop() );
+    }
+
+    {
+    TSETUP( std::auto_ptr< reader > p_reader( r_reader_factory.create( "a\nbcd" ) ) );
+    TCRITICALTEST( p_reader.get() != 0 );
+
+    TDOC( "The char got before a location was recorded can be ungot after returning to it" );
+    TTEST( p_reader->get() == 'a' );
+    TTEST( p_reader->get() == '\n' );
+    TSETUP( p_reader->location_push() );
+    TTEST( p_reader->get() == 'b' );
+    TTEST( p_reader->location_top() );
+    TSETUP( p_reader->unget( '\n' ) );
+    TTEST( p_reader->get_line_number() == 1 );
+    TTEST( p_reader->get() == '\n' );
+    TTEST( p_reader->get_line_number() == 2 );
+    TSETUP( p_reader->location_pop() );
+
+    TDOC( "Deeply nested locations" );
+    for( int i = 0; i < 1000; ++i )
+        p_reader->location_push();
+    TTEST( p_reader->get() == 'b' );
+    TTEST( p_reader->location_top() );
+    for( int i = 0; i < 999; ++i )
+        p_reader->location_pop();
+    TTEST( p_reader->get() == 'b' );
+    TTEST( p_reader->get() == 'c' );
+    TTEST( p_reader->location_top() );
+    TTEST( p_reader->get() == 'b' );
+    TTEST( p_reader->get_column_number() == 1 );
+    TSETUP( p_reader->location_pop() );
+    }
+
+    {
+    TSETUP( std::auto_ptr< reader > p_reader( r_reader_factory.create( "1234567\n8\nxy" ) ) );
+    TCRITICALTEST( p_reader.get() != 0 );
+
+    TDOC( "Up to 9 chars got before a location was recorded can be ungot after returning to it" );
+    const char * p_read = "1234567\n8\n";
+    for( const char * p_c = p_read; *p_c; ++p_c )
+        p_reader->get();
+    TSETUP( p_reader->location_push() );
+    TTEST( p_reader->get() == 'x' );
+    TTEST( p_reader->location_top() );
+    TTEST( p_reader->get_line_number() == 3 );
+    TSETUP( p_reader->unget( '\n' ) );
+    TTEST( p_reader->get_line_number() == 2 );
+    TTEST( p_reader->get_column_number() == 1 );
+    TSETUP( p_reader->unget( '8' ) );
+    TTEST( p_reader->get_line_number() == 2 );
+    TTEST( p_reader->get_column_number() == 0 );
+    TSETUP( p_reader->unget( '\n' ) );
+    TTEST( p_reader->get_line_number() == 1 );
+    TTEST( p_reader->get_column_number() == 7 );
+    for( const char * p_c = p_read + 6; p_c != p_read; --p_c )
+        p_reader->unget( *p_c );
+    TTEST( p_reader->get_line_number() == 1 );
+    TTEST( p_reader->get_column_number() == 1 );
+    for( const char * p_c = p_read + 1; *p_c; ++p_c )
+        p_reader->get();
+    TTEST( p_reader->get() == 'x' );
+    TTEST( p_reader->get_line_number() == 3 );
+    TTEST( p_reader->get_column_number() == 1 );
+    TSETUP( p_reader->location_pop() );
+    }
+}
+
 void reader_location_logger_test( reader_factory & r_reader_factory )
 {
     TBEGIN( (std::string( r_reader_factory.form_name() ) + " reader location logger tests").c_str() );
@@ -358,6 +528,57 @@ void reader_location_logger_test( reader_factory & r_reader_factory )
     TTEST( p_reader->get() == 'd' );
 }
 
+void reader_span_test( reader_factory & r_reader_factory )
+{
+    TBEGIN( (std::string( r_reader_factory.form_name() ) + " reader span tests").c_str() );
+
+    {
+    TSETUP( std::auto_ptr< reader > p_reader( r_reader_factory.create( "ab\ncdef" ) ) );
+    TCRITICALTEST( p_reader.get() != 0 );
+
+    const char * p_begin, * p_end;
+
+    TCRITICALTEST( p_reader->get_span( &p_begin, &p_end ) );
+    TTEST( p_end - p_begin == 7 );
+    TTEST( std::string( p_begin, p_end ) == "ab\ncdef" );
+    TSETUP( p_reader->consume( 4 ) );
+    TTEST( p_reader->current() == 'c' );
+    TTEST( p_reader->get_line_number() == 2 );
+    TTEST( p_reader->get_column_number() == 1 );
+    TTEST( p_reader->get() == 'd' );
+
+    TDOC( "unget() of the char just read doesn't block span access" );
+    TSETUP( p_reader->unget() );
+    TCRITICALTEST( p_reader->get_span( &p_begin, &p_end ) );
+    TTEST( std::string( p_begin, p_end ) == "def" );
+
+    TDOC( "unget() of a different char blocks span access" );
+    TSETUP( p_reader->unget( 'x' ) );
+    TTEST( ! p_reader->get_span( &p_begin, &p_end ) );
+    TTEST( p_reader->get() == 'x' );
+    TCRITICALTEST( p_reader->get_span( &p_begin, &p_end ) );
+
+    TDOC( "Spans work with locations" );
+    TSETUP( p_reader->location_push() );
+    TSETUP( p_reader->consume( 2 ) );
+    TTEST( p_reader->get() == 'f' );
+    TTEST( p_reader->get() == reader::R_EOI );
+    TTEST( ! p_reader->get_span( &p_begin, &p_end ) );
+    TTEST( p_reader->location_top() );
+    TCRITICALTEST( p_reader->get_span( &p_begin, &p_end ) );
+    TTEST( std::string( p_begin, p_end ) == "def" );
+    TSETUP( p_reader->location_pop() );
+    }
+
+    {
+    TSETUP( std::auto_ptr< reader > p_reader_empty( r_reader_factory.create( "" ) ) );
+    TCRITICALTEST( p_reader_empty.get() != 0 );
+
+    const char * p_begin, * p_end;
+    TTEST( ! p_reader_empty->get_span( &p_begin, &p_end ) );
+    }
+}
+
 void all_reader_tests( reader_factory & r_reader_factory )
 {
     reader_basic_test( r_reader_factory );
@@ -365,7 +586,9 @@ void all_reader_tests( reader_factory & r_reader_factory )
     reader_location_with_newline_test( r_reader_factory );
     reader_unget_test( r_reader_factory );
     reader_location_and_unget_test( r_reader_factory );
+    reader_location_frame_test( r_reader_factory );
     reader_location_logger_test( r_reader_factory );
+    reader_span_test( r_reader_factory );
 }
 
 TFUNCTION( string_reader_test )
@@ -389,6 +612,60 @@ TFUNCTION( mem_buf_reader_test )
     all_reader_tests( reader_factory_mem_buf() );
 }
 
+TFUNCTION( mmap_reader_test )
+{
+    TBEGIN( "Mmap reader tests" );
+
+    all_reader_tests( reader_factory_mmap() );
+}
+
+TFUNCTION( fd_reader_test )
+{
+    TBEGIN( "Fd reader tests" );
+
+    all_reader_tests( reader_factory_fd() );
+}
+
+#if ! defined( _WIN32 )
+TFUNCTION( fd_reader_pipe_test )
+{
+    TBEGIN( "Fd reader pipe tests" );
+
+    int fds[2];
+    TCRITICALTEST( pipe( fds ) == 0 );
+
+    const char * p_data = "abc\ndef";
+    TCRITICALTEST( write( fds[1], p_data, strlen( p_data ) ) == static_cast< ssize_t >( strlen( p_data ) ) );
+    close( fds[1] );
+
+    reader_fd my_reader( fds[0], true );
+
+    TTEST( my_reader.is_open() );
+    TSETUP( my_reader.location_push() );
+    TTEST( my_reader.get() == 'a' );
+    TTEST( my_reader.get() == 'b' );
+    TSETUP( my_reader.location_push() );
+    TTEST( my_reader.get() == 'c' );
+    TTEST( my_reader.get() == '\n' );
+    TTEST( my_reader.get() == 'd' );
+    TTEST( my_reader.get_line_number() == 2 );
+    TSETUP( my_reader.location_top() );
+    TTEST( my_reader.get() == 'c' );
+    TTEST( my_reader.get_line_number() == 1 );
+    TSETUP( my_reader.location_pop() );
+    TSETUP( my_reader.location_top() );
+    TTEST( my_reader.get() == 'a' );
+    TSETUP( my_reader.location_pop() );
+    TTEST( my_reader.get() == 'b' );
+    TTEST( my_reader.get() == 'c' );
+    TTEST( my_reader.get() == '\n' );
+    TTEST( my_reader.get() == 'd' );
+    TTEST( my_reader.get() == 'e' );
+    TTEST( my_reader.get() == 'f' );
+    TTEST( my_reader.get() == reader::R_EOI );
+}
+#endif
+
 TFUNCTION( is_get_char_reader_test )
 {
     TBEGIN( "is get char reader tests" );
@@ -549,6 +826,146 @@ TFUNCTION( reader_blank_line_counting_test )
     }
 }
 
+TFUNCTION( reader_lazy_line_counting_test )
+{
+    TBEGIN( "Reader lazy line counting tests" );
+
+    const char * p_input = "ab\r\ncd\nef\rgh\r\n\r\nij\n\n\r\r\n\rkl";
+
+    {
+    reader_string my_eager_reader( p_input );
+    reader_string my_lazy_reader( p_input );
+
+    TTEST( ! my_lazy_reader.is_lazy_line_counting() );
+    TTEST( my_lazy_reader.set_lazy_line_counting( true ) );
+    TTEST( my_lazy_reader.is_lazy_line_counting() );
+
+    TDOC( "Lazy and eager line counting agree at each char" );
+    bool is_same = true;
+    for( size_t i = 0; i < strlen( p_input ); ++i )
+    {
+        my_eager_reader.get();
+        my_lazy_reader.get();
+        if( my_eager_reader.get_line_number() != my_lazy_reader.get_line_number() ||
+                my_eager_reader.get_column_number() != my_lazy_reader.get_column_number() )
+            is_same = false;
+    }
+    TTEST( is_same );
+    TTEST( my_lazy_reader.get_line_number() == 11 );
+    TTEST( my_lazy_reader.get_column_number() == 2 );
+    }
+
+    {
+    reader_string my_reader( p_input );
+
+    TTEST( my_reader.set_lazy_line_counting( true ) );
+    TTEST( my_reader.get_line_number() == 1 );
+    TTEST( my_reader.get_column_number() == 0 );
+    TTEST( my_reader.get() == 'a' );
+    TTEST( my_reader.get() == 'b' );
+    TSETUP( my_reader.location_push() );
+    TTEST( my_reader.get() == '\r' );
+    TTEST( my_reader.get() == '\n' );
+    TTEST( my_reader.get() == 'c' );
+    TTEST( my_reader.get_line_number() == 2 );
+    TTEST( my_reader.get_column_number() == 1 );
+
+    TDOC( "Going back recalculates the position" );
+    TTEST( my_reader.location_top() );
+    TTEST( my_reader.get_line_number() == 1 );
+    TTEST( my_reader.get_column_number() == 2 );
+    TTEST( my_reader.get() == '\r' );
+    TTEST( my_reader.get_line_number() == 2 );
+    TSETUP( my_reader.unget() );
+    TTEST( my_reader.get_line_number() == 1 );
+    TSETUP( my_reader.location_pop() );
+
+    TDOC( "Returning to eager line counting continues from the current position" );
+    TTEST( my_reader.get() == '\r' );
+    TTEST( my_reader.set_lazy_line_counting( false ) );
+    TTEST( ! my_reader.is_lazy_line_counting() );
+    TTEST( my_reader.get() == '\n' );
+    TTEST( my_reader.get_line_number() == 2 );
+    TTEST( my_reader.get() == 'c' );
+    TTEST( my_reader.get_line_number() == 2 );
+    TTEST( my_reader.get_column_number() == 1 );
+    }
+
+    {
+    reader_string my_reader( "ab\ncd" );
+
+    TDOC( "Lazy counting started part way through the input" );
+    TTEST( my_reader.get() == 'a' );
+    TTEST( my_reader.get() == 'b' );
+    TTEST( my_reader.get() == '\n' );
+    TTEST( my_reader.set_lazy_line_counting( true ) );
+    TTEST( my_reader.get_line_number() == 2 );
+    TTEST( my_reader.get() == 'c' );
+    TTEST( my_reader.get_line_number() == 2 );
+    TTEST( my_reader.get_column_number() == 1 );
+    }
+
+    {
+    // Long runs without newlines and mixed runs of newlines
+    std::string input;
+    unsigned int seed = 1;
+    for( size_t i = 0; i < 20000; ++i )
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned int r = (seed >> 16) % 64;
+        input += r < 4 ? "\r\n\r\n"[r] : r < 60 ? 'x' : ' ';
+    }
+    input += std::string( 100, 'y' );
+
+    reader_string my_eager_reader( input );
+    reader_string my_lazy_reader( input );
+    TTEST( my_lazy_reader.set_lazy_line_counting( true ) );
+
+    TDOC( "Lazy line counting with a newline index agrees with eager line counting" );
+    std::vector< int > line_numbers, column_numbers;
+    bool is_same = true;
+    for( size_t i = 0; i < input.size(); ++i )
+    {
+        my_eager_reader.get();
+        line_numbers.push_back( my_eager_reader.get_line_number() );
+        column_numbers.push_back( my_eager_reader.get_column_number() );
+        if( i % 1000 == 0 )
+            my_lazy_reader.location_push();
+        my_lazy_reader.get();
+        if( i % 3 == 0 && (my_lazy_reader.get_line_number() != line_numbers.back() ||
+                my_lazy_reader.get_column_number() != column_numbers.back()) )
+            is_same = false;
+    }
+    TTEST( is_same );
+    TTEST( my_lazy_reader.get_line_number() == my_eager_reader.get_line_number() );
+    TTEST( my_lazy_reader.get_column_number() == my_eager_reader.get_column_number() );
+
+    TDOC( "Looking up earlier positions" );
+    is_same = true;
+    for( size_t i = 21; i > 0; --i )
+    {
+        my_lazy_reader.location_top();
+        my_lazy_reader.location_pop();
+        size_t index = (i - 1) * 1000 - 1;
+        if( i > 1 && (my_lazy_reader.get_line_number() != line_numbers[index] ||
+                my_lazy_reader.get_column_number() != column_numbers[index]) )
+            is_same = false;
+    }
+    TTEST( is_same );
+    TTEST( my_lazy_reader.get_line_number() == 1 );
+    TTEST( my_lazy_reader.get_column_number() == 0 );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_file().create( "ab\ncd" ) );
+
+    TDOC( "Readers that don't hold all their input in memory don't support lazy line counting" );
+    TTEST( ! p_reader->set_lazy_line_counting( true ) );
+    TTEST( ! p_reader->is_lazy_line_counting() );
+    TTEST( p_reader->set_lazy_line_counting( false ) );
+    }
+}
+
 TFUNCTION( reader_is_open_test )
 {
     TBEGIN( "Reader::is_open() tests" );
@@ -565,9 +982,129 @@ TFUNCTION( reader_is_open_test )
     TTEST( ! my_reader.is_open() );
     }
 
+    {
+    reader_mmap my_reader( "l:\\::::" );    // Illegal file name
+
+    TTEST( ! my_reader.is_open() );
+    TTEST( my_reader.get() == reader::R_EOI );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_mmap().create( "abc d" ) );
+
+    TTEST( p_reader->is_open() );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_mmap().create( "" ) );  // An empty regular file is valid input
+
+    TTEST( p_reader->is_open() );
+    TTEST( p_reader->get() == reader::R_EOI );
+    }
+
+#if ! defined( _WIN32 )
+    {
+    reader_mmap my_reader( "/dev/null" );   // Not a regular file, even though it has a size of 0
+
+    TTEST( ! my_reader.is_open() );
+    TTEST( my_reader.get() == reader::R_EOI );
+    }
+#endif
+
     {
     std::auto_ptr< reader > p_reader( reader_factory_file().create( "abc d" ) );
 
     TTEST( p_reader->is_open() );
     }
+
+    {
+    reader_fd my_reader( -1 );
+
+    TTEST( ! my_reader.is_open() );
+    TTEST( my_reader.get() == reader::R_EOI );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_fd().create( "abc d" ) );
+
+    TTEST( p_reader->is_open() );
+    }
+}
+
+TFUNCTION( reader_is_input_stable_test )
+{
+    TBEGIN( "Reader::is_input_stable() tests" );
+
+    {
+    reader_string my_reader( "abc d" );
+
+    TTEST( my_reader.is_input_stable() );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_mem_buf().create( "abc d" ) );
+
+    TTEST( p_reader->is_input_stable() );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_mmap().create( "abc d" ) );
+
+    TTEST( p_reader->is_input_stable() );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_file().create( "abc d" ) );
+
+    TTEST( ! p_reader->is_input_stable() );
+    }
+
+    {
+    std::auto_ptr< reader > p_reader( reader_factory_fd().create( "abc d" ) );
+
+    TTEST( ! p_reader->is_input_stable() );
+    }
+}
+
+TFUNCTION( reader_mutable_input_test )
+{
+    TBEGIN( "Reader::mutable_input() tests" );
+
+    {
+    reader_string my_reader( "abc d" );
+    const char * p_begin, * p_end;
+
+    TTEST( my_reader.get_span( &p_begin, &p_end ) );
+    TTEST( my_reader.mutable_input( p_begin ) == 0 );
+    }
+
+    {
+    char buffer[] = "abc d";
+    reader_mutable_mem_buf my_reader( buffer, 5 );
+    const char * p_begin, * p_end;
+
+    TTEST( my_reader.is_input_stable() );
+    TTEST( my_reader.get() == 'a' );
+    TTEST( my_reader.get_span( &p_begin, &p_end ) );
+    TTEST( my_reader.mutable_input( p_begin ) == buffer + 1 );
+    TTEST( my_reader.mutable_input( buffer + 5 ) == 0 );
+    TTEST( my_reader.get() == 'b' );
+    }
+
+    {
+    std::vector< char > input( 3, 'x' );
+    reader_mutable_mem_buf my_reader( input );
+    const char * p_begin, * p_end;
+
+    TTEST( my_reader.get_span( &p_begin, &p_end ) );
+    TTEST( my_reader.mutable_input( p_begin ) == &input[0] );
+    TTEST( p_end - p_begin == 3 );
+    }
+
+    {
+    std::vector< char > input;
+    reader_mutable_mem_buf my_reader( input );
+
+    TTEST( my_reader.get() == reader::R_EOI );
+    }
 }
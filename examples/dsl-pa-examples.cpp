@@ -259,11 +259,11 @@ bool example_parser::get_date( date * p_date )
     // function exits.
     locator my_location( get_reader() );
 
-    if( get_int( &p_date->year ) == 4 &&
+    if( get_fixed_width_uint( &p_date->year, 4 ) &&
             is_get_char( '-' ) &&
-            get_int( &p_date->month ) == 2 &&
+            get_fixed_width_uint( &p_date->month, 2 ) &&
             is_get_char( '-' ) &&
-            get_int( &p_date->dom ) == 2 )
+            get_fixed_width_uint( &p_date->dom, 2 ) )
         return true;
 
     location_top();
@@ -305,7 +305,9 @@ void example_parser::example7( std::ostream & fout )
     // are built-in, such as alphabet_space as used below.  The built-in
     // alphabets are efficient to construct and hence can be constructed in
     // place, but alphabet_char_class alphabets require some computation to
-    // setup and are therefore better setup as const global objects:
+    // setup and are therefore better setup as const global objects, or
+    // obtained in place using alphabet_char_class::intern( "IVXLCM" ), which
+    // returns an alphabet shared by all callers using the same spec:
     std::string roman_number;
     std::string non_space;
 
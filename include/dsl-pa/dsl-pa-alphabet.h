@@ -42,9 +42,19 @@
 #define CL_DSL_PA_ALPHABET
 
 #include <cctype>
+#include <cstring>
 
 #include "dsl-pa-reader.h"
 
+// MSVC only sets __cplusplus to the language version when /Zc:__cplusplus is
+// used, but always sets _MSVC_LANG
+#if __cplusplus >= 201402L || defined( _MSVC_LANG ) && _MSVC_LANG >= 201402L
+    #define CL_DSL_PA_CPP14
+    #define CL_DSL_PA_CONSTEXPR14 constexpr
+#else
+    #define CL_DSL_PA_CONSTEXPR14
+#endif
+
 namespace cl {
 
 namespace /*cl::*/alphabet_helpers {
@@ -84,6 +94,9 @@ namespace /*cl::*/alphabet_helpers {
     {
         return ! is_7bit( c );
     }
+    #if __cplusplus >= 201103L
+    constexpr
+    #endif
     inline size_t char_to_size_t( char c )
     {
         // Convert char to range 0 to 255. Helper for indexing into array.
@@ -91,23 +104,68 @@ namespace /*cl::*/alphabet_helpers {
     }
 }   // End of namespace cl::*/alphabet_helpers
 
+// char_map holds a bit for each of the 256 char values.  The bits are laid
+// out so that byte [lo] holds bit hi for chars with high nibble hi < 8, and
+// byte [16 + lo] holds bit (hi - 8) for the rest.  This is the layout that
+// find_first_set() and find_first_not_set() need to look up a block of chars
+// at a time with nibble shuffles.  With C++14, a char_map can be built at
+// compile time (see alphabet_ct).
+
 class char_map
 {
 private:
-    typedef char char_map_array[256];
-    char_map_array index;
+    unsigned char bits[32];
+
+    static CL_DSL_PA_CONSTEXPR14 size_t byte_index( char c )
+    {
+        size_t i = alphabet_helpers::char_to_size_t( c );
+        return (i & 0x0f) + ((i & 0x80) >> 3);
+    }
+    static CL_DSL_PA_CONSTEXPR14 unsigned char bit( char c )
+    {
+        return static_cast< unsigned char >( 1 << ((alphabet_helpers::char_to_size_t( c ) >> 4) & 0x07) );
+    }
 
 public:
-    char_map();
-    void clear();
-    char_map & clear( char c );
-    char_map & set( char c );
-    char_map & set_range( char start, char end );
-    char_map & set_inverted_range( char start, char end );
-    char_map & invert();
-    void merge( const char_map & r_rhs );
+    CL_DSL_PA_CONSTEXPR14 char_map() : bits() {}
+    // Copy 32 bytes laid out as in bits
+    explicit char_map( const unsigned char * p_bits ) { memcpy( bits, p_bits, sizeof( bits ) ); }
+    CL_DSL_PA_CONSTEXPR14 void clear()
+    {
+        for( size_t i=0; i<32; ++i )
+            bits[i] = 0;
+    }
+    CL_DSL_PA_CONSTEXPR14 char_map & clear( char c ) { bits[byte_index( c )] &= ~bit( c ); return *this; }
+    CL_DSL_PA_CONSTEXPR14 char_map & set( char c ) { bits[byte_index( c )] |= bit( c ); return *this; }
+    CL_DSL_PA_CONSTEXPR14 char_map & set_range( char start, char end )
+    {
+        for( size_t i = alphabet_helpers::char_to_size_t( start ); i <= alphabet_helpers::char_to_size_t( end ); ++i )
+            set( static_cast< char >( i ) );
+        return *this;
+    }
+    CL_DSL_PA_CONSTEXPR14 char_map & set_inverted_range( char start, char end )
+    {
+        merge( char_map().set_range( start, end ).invert() );
+        return *this;
+    }
+    CL_DSL_PA_CONSTEXPR14 char_map & invert()
+    {
+        for( size_t i=0; i<32; ++i )
+            bits[i] = static_cast< unsigned char >( ~bits[i] );
+        return *this;
+    }
+    CL_DSL_PA_CONSTEXPR14 void merge( const char_map & r_rhs )
+    {
+        for( size_t i=0; i<32; ++i )
+            bits[i] |= r_rhs.bits[i];
+    }
+
+    CL_DSL_PA_CONSTEXPR14 bool is_set( char c ) const { return (bits[byte_index( c )] & bit( c )) != 0; }
 
-    bool is_set( char c ) const;
+    // Return a pointer to the first char in [p_begin, p_end) that is (or is
+    // not) set, or p_end if there isn't one
+    const char * find_first_set( const char * p_begin, const char * p_end ) const;
+    const char * find_first_not_set( const char * p_begin, const char * p_end ) const;
 };
 
 // Specialist char maps corresponding to the Perl \w, \d and \s expressions
@@ -115,31 +173,198 @@ public:
 class char_map_w : public char_map
 {
 public:
-    char_map_w();
+    CL_DSL_PA_CONSTEXPR14 char_map_w()
+    {
+        set_range( 'a', 'z' ).set_range( 'A', 'Z' ).set_range( '0', '9' ).set( '_' );
+    }
 };
 
 class char_map_d : public char_map
 {
 public:
-    char_map_d();
+    CL_DSL_PA_CONSTEXPR14 char_map_d()
+    {
+        set_range( '0', '9' );
+    }
 };
 
 class char_map_s : public char_map
 {
 public:
-    char_map_s();
+    CL_DSL_PA_CONSTEXPR14 char_map_s()
+    {
+        set( ' ' ).set( '\t' ).set( '\r' ).set( '\n' );
+    }
 };
 
 class char_map_l : public char_map
 {
 public:
-    char_map_l();
+    CL_DSL_PA_CONSTEXPR14 char_map_l()
+    {
+        set_range( 'a', 'z' ).set_range( 'A', 'Z' );
+    }
 };
 
+namespace /*cl::*/alphabet_helpers {
+    // The parser for alphabet_char_class specs.  With C++14 it also runs at
+    // compile time for alphabet_ct.
+    CL_DSL_PA_CONSTEXPR14 inline bool add_special_char_class( char_map * p_wanted_chars, char key )
+    {
+        switch( key )
+        {
+        case 'w':
+            p_wanted_chars->merge( char_map_w() );
+        break;
+
+        case 'W':
+            p_wanted_chars->merge( char_map_w().invert() );
+        break;
+
+        case 'd':
+            p_wanted_chars->merge( char_map_d() );
+        break;
+
+        case 'D':
+            p_wanted_chars->merge( char_map_d().invert() );
+        break;
+
+        case 's':
+            p_wanted_chars->merge( char_map_s() );
+        break;
+
+        case 'S':
+            p_wanted_chars->merge( char_map_s().invert() );
+        break;
+
+        case 'l':
+            p_wanted_chars->merge( char_map_l() );
+        break;
+
+        case 'L':
+            p_wanted_chars->merge( char_map_l().invert() );
+        break;
+
+        case 'u':
+            p_wanted_chars->set_range( '\x21', '\xff' );
+        break;
+
+        // The following included for completeness.  Instead of ~t you could do \t etc.
+        case 't':
+            p_wanted_chars->set( '\t' );
+        break;
+
+        case 'r':
+            p_wanted_chars->set( '\r' );
+        break;
+
+        case 'n':
+            p_wanted_chars->set( '\n' );
+        break;
+
+        case '\0':
+            p_wanted_chars->set( '~' );
+            return false;
+
+        default:    // Includes \, ~ and -
+            p_wanted_chars->set( key );
+        }
+
+        return true;
+    }
+
+    CL_DSL_PA_CONSTEXPR14 inline char_map char_class_map( const char * p_spec )
+    {
+        char_map wanted_chars;
+
+        bool is_inverted = false;
+
+        if( *p_spec == '^' )
+        {
+            is_inverted = true;
+            ++p_spec;
+        }
+
+        char last_char = static_cast< char >( 0xff );
+
+        for( ; *p_spec != '\0'; ++p_spec )
+        {
+            if( *p_spec == '-' )            // Allow for ranges
+            {
+                if( *++p_spec == '\0' )
+                {
+                    wanted_chars.set( '-' );
+                    return wanted_chars;
+                }
+                wanted_chars.set_range( last_char, *p_spec );   // Don't ++ last_char here incase we have a spec of a-a!
+            }
+
+            else if( *p_spec == '\\' || *p_spec == '~' )        // Allow for specials
+            {
+                if( ! add_special_char_class( &wanted_chars, *++p_spec ) )
+                    return wanted_chars;
+            }
+
+            else
+            {
+                wanted_chars.set( last_char = *p_spec );
+            }
+        }
+
+        if( is_inverted )
+            wanted_chars.invert();
+
+        wanted_chars.clear( reader::R_EOI );    // No alphabets want EOI ('\0')
+
+        return wanted_chars;
+    }
+}   // End of namespace cl::*/alphabet_helpers
+
+class alphabet_flat;
+
 class alphabet
 {
 public:
     virtual bool is_sought( char c ) const = 0;
+
+    // sought_prefix_length() returns the number of chars at the start of
+    // [p_begin, p_end) that are sought, and unsought_prefix_length() returns
+    // the number that aren't, so that a run of input can be scanned with one
+    // virtual call.  The default versions use the char_map from
+    // get_char_map() if there is one, and otherwise call is_sought() for each
+    // char.  The library's alphabets override these, or get_char_map(), to
+    // scan more quickly, so a class that derives from one of them and
+    // overrides is_sought() must also override both of these, e.g. by
+    // calling sought_prefix_length_by_char() and
+    // unsought_prefix_length_by_char().
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const;
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const;
+
+    // If is_sought() is equivalent to looking up a char_map, get_char_map()
+    // can return that char_map so that runs of input can be scanned a block
+    // at a time.
+    virtual const char_map * get_char_map() const { return 0; }
+
+    // flatten() returns an alphabet that holds its own copy of the chars
+    // this alphabet seeks.  See alphabet_flat.
+    alphabet_flat flatten() const;
+
+protected:
+    // Call is_sought() for each char
+    size_t sought_prefix_length_by_char( const char * p_begin, const char * p_end ) const
+    {
+        const char * p_c = p_begin;
+        while( p_c != p_end && is_sought( *p_c ) )
+            ++p_c;
+        return p_c - p_begin;
+    }
+    size_t unsought_prefix_length_by_char( const char * p_begin, const char * p_end ) const
+    {
+        const char * p_c = p_begin;
+        while( p_c != p_end && ! is_sought( *p_c ) )
+            ++p_c;
+        return p_c - p_begin;
+    }
 };
 
 class alphabet_char : public alphabet
@@ -155,6 +380,18 @@ public:
     {
         return c == sought;
     }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        const char * p_c = p_begin;
+        while( p_c != p_end && *p_c == sought )
+            ++p_c;
+        return p_c - p_begin;
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        const void * p_found = memchr( p_begin, sought, p_end - p_begin );
+        return p_found ? static_cast< const char * >( p_found ) - p_begin : p_end - p_begin;
+    }
 };
 
 // This alphabet class takes a specification that mirrors a Perl character
@@ -175,6 +412,18 @@ public:
 //
 // The Perl special char classes of \w, \W, \d, \D, \s and \S are supported.
 // To specify \ do "\\\\", to specify ~ do "~~".
+//
+// Parsing the spec takes some computation, so rather than constructing an
+// alphabet_char_class each time a parsing function is called, either make it
+// a const global object, or use intern(), which returns a reference to an
+// alphabet_char_class shared by all users of the same spec.  intern() may be
+// called from multiple threads, and the returned alphabet lasts for the rest
+// of the program.  Once a spec has been interned, intern() finds it without
+// taking a lock, but it still hashes and compares the spec, so where it
+// would be called repeatedly keep the reference it returns, e.g.:
+//
+//      const alphabet_char_class & r_roman_chars = alphabet_char_class::intern( "IVXLCM" );
+//      while( get( &roman_number, r_roman_chars ) )
 
 class alphabet_char_class : public alphabet
 {
@@ -182,17 +431,54 @@ private:
     char_map wanted_chars;
 
 public:
-    alphabet_char_class( const char * p_char_class_spec );
+    alphabet_char_class( const char * p_char_class_spec )
+        : wanted_chars( alphabet_helpers::char_class_map( p_char_class_spec ) )
+    {}
+    static const alphabet_char_class & intern( const char * p_char_class_spec );
     virtual bool is_sought( char c ) const
     {
         return wanted_chars.is_set( c );
     }
+    virtual const char_map * get_char_map() const
+    {
+        return &wanted_chars;
+    }
+};
 
+#if defined( CL_DSL_PA_CPP14 )
+// alphabet_ct is a compile-time version of alphabet_char_class.  The spec
+// is parsed when the program is compiled, by the same parser as
+// alphabet_char_class.  As a string literal can't be a template argument,
+// the spec must be declared as a named char array, e.g.:
+//
+//      constexpr char hex_spec[] = "0-9a-fA-F";
+//      alphabet_ct< hex_spec > my_hex_alphabet;
+//
+// alphabet_ct< hex_spec >::is_in( c ) does the same as is_sought( c ) but is
+// non-virtual, so can be inlined into templated code.  Requires C++14.
+
+template< const char * p_spec >
+class alphabet_ct : public alphabet
+{
 private:
-    bool add_range( char start, char end );
-    bool add_special_char_class( char key );
+    static constexpr char_map wanted_chars = alphabet_helpers::char_class_map( p_spec );
+
+public:
+    static bool is_in( char c )
+    {
+        return wanted_chars.is_set( c );
+    }
+    virtual bool is_sought( char c ) const final
+    {
+        return is_in( c );
+    }
+    virtual const char_map * get_char_map() const final { return &wanted_chars; }
 };
 
+template< const char * p_spec >
+constexpr char_map alphabet_ct< p_spec >::wanted_chars;
+#endif
+
 // alphabet_function calls a non-member function to see if the input
 // character is wanted
 
@@ -210,87 +496,150 @@ public:
     {
         return f( c );
     }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        const char * p_c = p_begin;
+        while( p_c != p_end && f( *p_c ) )
+            ++p_c;
+        return p_c - p_begin;
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        const char * p_c = p_begin;
+        while( p_c != p_end && ! f( *p_c ) )
+            ++p_c;
+        return p_c - p_begin;
+    }
 };
 
 // Common alphabets
 
+// Each of these copies its char_map from a constant table when it is
+// constructed, so that it needs no static initialisation and can be used
+// from any thread or during another translation unit's static
+// initialisation.
+
 class alphabet_space : public alphabet
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_space();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_space( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_line_space : public alphabet   // Non-newline space chars
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_line_space();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_line_space( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_eol : public alphabet    // End of Line
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_eol();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_eol( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_digit : public alphabet
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_digit();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_digit( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_hex : public alphabet
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_hex();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_hex( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_alpha : public alphabet
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_alpha();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_alpha( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_word_first_char : public alphabet    // Based on Perl's \w
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_word_first_char();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_alpha( c ) || '_' == c;
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_word_char : public alphabet
 {
+private:
+    char_map wanted_chars;
+
+protected:
+    explicit alphabet_word_char( const unsigned char * p_bits ) : wanted_chars( p_bits ) {}
+
 public:
+    alphabet_word_char();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_alpha( c ) ||
                 alphabet_helpers::is_digit( c ) ||
                 '_' == c;
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_name_char : public alphabet_word_char
 {
 public:
+    alphabet_name_char();
     virtual bool is_sought( char c ) const
     {
         return '-' == c || alphabet_word_char::is_sought( c );
@@ -299,11 +648,16 @@ public:
 
 class alphabet_uni : public alphabet // char is part of a non-ASCII Unicode sequence
 {
+private:
+    char_map wanted_chars;
+
 public:
+    alphabet_uni();
     virtual bool is_sought( char c ) const
     {
         return alphabet_helpers::is_utf8_multibyte( c );
     }
+    virtual const char_map * get_char_map() const { return &wanted_chars; }
 };
 
 class alphabet_sign : public alphabet
@@ -397,6 +751,12 @@ public:
     {
         return c != reader::R_EOI && ! r_alphabet.is_sought( c );
     }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        size_t length = r_alphabet.unsought_prefix_length( p_begin, p_end );
+        const void * p_eoi = memchr( p_begin, reader::R_EOI, length );
+        return p_eoi ? static_cast< const char * >( p_eoi ) - p_begin : length;
+    }
 };
 
 class alphabet_or : public alphabet
@@ -418,6 +778,24 @@ public:
         return r_alphabet_1.is_sought( c ) ||
                 r_alphabet_2.is_sought( c );
     }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        // Alternate between the alphabets until neither makes progress
+        const char * p_c = p_begin;
+        for( ;; )
+        {
+            const char * p_start = p_c;
+            p_c += r_alphabet_1.sought_prefix_length( p_c, p_end );
+            p_c += r_alphabet_2.sought_prefix_length( p_c, p_end );
+            if( p_c == p_start )
+                return p_c - p_begin;
+        }
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        size_t length = r_alphabet_1.unsought_prefix_length( p_begin, p_end );
+        return r_alphabet_2.unsought_prefix_length( p_begin, p_begin + length );
+    }
 };
 
 class alphabet_and : public alphabet
@@ -439,6 +817,50 @@ public:
         return r_alphabet_1.is_sought( c ) &&
                 r_alphabet_2.is_sought( c );
     }
+    virtual size_t sought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        size_t length = r_alphabet_1.sought_prefix_length( p_begin, p_end );
+        return r_alphabet_2.sought_prefix_length( p_begin, p_begin + length );
+    }
+    virtual size_t unsought_prefix_length( const char * p_begin, const char * p_end ) const
+    {
+        // Alternate between the alphabets until neither makes progress
+        const char * p_c = p_begin;
+        for( ;; )
+        {
+            const char * p_start = p_c;
+            p_c += r_alphabet_1.unsought_prefix_length( p_c, p_end );
+            p_c += r_alphabet_2.unsought_prefix_length( p_c, p_end );
+            if( p_c == p_start )
+                return p_c - p_begin;
+        }
+    }
+};
+
+// alphabet_flat works out once which chars another alphabet seeks and
+// records them in a char_map.  This makes combinations of alphabets, such as
+// alphabet_or( alphabet_word_char(), alphabet_or( alphabet_dash(),
+// alphabet_point() ) ), a single lookup per char.  As it keeps no
+// reference to the original alphabet, the original can be a temporary, e.g.:
+//
+//      const alphabet_flat name_chars = alphabet_or( alphabet_word_char(), alphabet_dash() ).flatten();
+
+class alphabet_flat : public alphabet
+{
+private:
+    char_map wanted_chars;
+
+public:
+    alphabet_flat( const alphabet & r_alphabet );
+    alphabet_flat( const char_map & r_char_map ) : wanted_chars( r_char_map ) {}
+    virtual bool is_sought( char c ) const
+    {
+        return wanted_chars.is_set( c );
+    }
+    virtual const char_map * get_char_map() const
+    {
+        return &wanted_chars;
+    }
 };
 
 namespace /*cl::*/ short_alphabets {
@@ -456,6 +878,7 @@ namespace /*cl::*/ short_alphabets {
     typedef alphabet_not                Not;    // Not, Or & And start with upper case to avoid confusion with C++03 alternative names for !, !! and &&
     typedef alphabet_or                 Or;
     typedef alphabet_and                And;
+    typedef alphabet_flat               flat;
     typedef alphabet_sign               sign;
     typedef alphabet_point              point;
     typedef alphabet_dot                dot;
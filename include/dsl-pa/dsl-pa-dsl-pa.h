@@ -42,7 +42,11 @@
 #define CL_DSL_PA_DSL_PA
 
 #include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 #include "dsl-pa-reader.h"
 #include "dsl-pa-alphabet.h"
@@ -105,6 +109,142 @@ public:
     }
 };
 
+// string_ref is the output of the get...() methods that avoid copying their
+// result.  Where the reader's input is stable (see
+// reader::is_input_stable()) and the result is an unmodified run of the
+// input, a string_ref refers directly to the reader's input and is valid for
+// as long as the input is.  Otherwise, e.g. when a q-string contains escape
+// sequences, the result is held in the string_ref's own buffer.  For
+// example:
+//
+//      cl::string_ref name;
+//      if( my_parser.get( &name, cl::alphabet_alpha() ) && name == "GET" )
+//          ...
+
+class string_ref
+{
+private:
+    const char * p_data;
+    size_t length;
+    std::string buffer;
+    bool is_buffered;
+
+public:
+    string_ref() : p_data( "" ), length( 0 ), is_buffered( false ) {}
+    string_ref( const char * p_data_in, size_t length_in )
+        : p_data( p_data_in ), length( length_in ), is_buffered( false )
+    {}
+
+    const char * data() const { return is_buffered ? buffer.data() : p_data; }
+    size_t size() const { return is_buffered ? buffer.size() : length; }
+    bool empty() const { return size() == 0; }
+    const char * begin() const { return data(); }
+    const char * end() const { return data() + size(); }
+    char operator [] ( size_t index ) const { return data()[index]; }
+    std::string str() const { return std::string( data(), size() ); }
+    bool is_in_place() const { return ! is_buffered; }  // True if the chars aren't held in the buffer
+
+    void clear() { set( "", 0 ); }
+    void set( const char * p_data_in, size_t length_in )
+    {
+        p_data = p_data_in;
+        length = length_in;
+        buffer.clear();
+        is_buffered = false;
+    }
+    std::string * set_buffered()    // Returns the cleared buffer for the chars to be written to
+    {
+        buffer.clear();
+        is_buffered = true;
+        return &buffer;
+    }
+};
+
+inline bool operator == ( const string_ref & r_lhs, const string_ref & r_rhs )
+{
+    return r_lhs.size() == r_rhs.size() && std::equal( r_lhs.begin(), r_lhs.end(), r_rhs.begin() );
+}
+inline bool operator == ( const string_ref & r_lhs, const char * p_rhs )
+{
+    return r_lhs == string_ref( p_rhs, strlen( p_rhs ) );
+}
+inline bool operator == ( const string_ref & r_lhs, const std::string & r_rhs )
+{
+    return r_lhs == string_ref( r_rhs.data(), r_rhs.size() );
+}
+template< typename T >
+inline bool operator != ( const string_ref & r_lhs, const T & r_rhs )
+{
+    return ! (r_lhs == r_rhs);
+}
+
+// keyword_set holds a set of literal keywords compiled into a trie so that
+// dsl_pa::fixed_one_of() can find the longest of them at the current input
+// location in a single forward pass, rather than trying each with fixed() in
+// turn.  Keywords are identified by the order in which they were added,
+// starting at 0.  If a keyword is added more than once, the first index is
+// used.  With is_case_insensitive set, ASCII letters are matched ignoring
+// case, as with ifixed().  For example:
+//
+//      static const char * const methods[] = { "GET", "POST", "PUT", "DELETE" };
+//      static const keyword_set http_methods( methods, 4 );
+//      size_t method;
+//      if( my_parser.fixed_one_of( http_methods, &method ) )
+//          ...
+
+class keyword_set
+{
+private:
+    struct node
+    {
+        char c;
+        size_t first_child;     // 0 if none; the root can't be a child
+        size_t next_sibling;    // 0 if none
+        size_t keyword_index;   // not_found if no keyword ends here
+
+        node( char c_in )
+            : c( c_in ), first_child( 0 ), next_sibling( 0 ), keyword_index( ~0 )
+        {}
+    };
+
+    std::vector< node > nodes;
+    std::vector< std::string > keywords;
+    bool is_case_insensitive_set;
+
+    char fold( char c ) const
+    {
+        return (is_case_insensitive_set && c >= 'A' && c <= 'Z') ? static_cast<char>( c - 'A' + 'a' ) : c;
+    }
+
+public:
+    const static size_t not_found = ~0;
+
+    keyword_set( bool is_case_insensitive = false );
+    keyword_set( const char * const p_keywords[], size_t n_keywords, bool is_case_insensitive = false );
+
+    keyword_set & add( const char * p_keyword );
+
+    size_t size() const { return keywords.size(); }
+    bool empty() const { return keywords.empty(); }
+    const std::string & keyword( size_t index ) const { return keywords[index]; }
+    bool is_case_insensitive() const { return is_case_insensitive_set; }
+
+    // Trie traversal used by dsl_pa::fixed_one_of().  Start at root() and
+    // call next() with each input char.  next() returns root() when there
+    // is no onward path.
+    size_t root() const { return 0; }
+    size_t next( size_t node_index, char c ) const
+    {
+        c = fold( c );
+        for( size_t child = nodes[node_index].first_child; child != 0; child = nodes[child].next_sibling )
+            if( nodes[child].c == c )
+                return child;
+        return 0;
+    }
+    bool has_next( size_t node_index ) const { return nodes[node_index].first_child != 0; }
+    size_t keyword_index( size_t node_index ) const { return nodes[node_index].keyword_index; }
+};
+
 class accumulator_deferred;
 
 class dsl_pa
@@ -118,11 +258,25 @@ private:
     template< typename Twriter >
     size_t read_or_skip_handler( std::string * p_output, const alphabet & r_alphabet, size_t max_chars );
     template< typename Twriter >
-    size_t read_or_skip_until_handler( std::string * p_output, const alphabet & r_alphabet, char escape_char, size_t max_chars );
+    size_t read_or_skip_until_handler( typename Twriter::output_type p_output, const alphabet & r_alphabet, char escape_char, size_t max_chars );
     template< typename Twriter >
     size_t read_or_skip_handler( std::string * p_output, mutator & r_mutator );
     template< class Tcomparer >
     bool read_fixed_or_ifixed( std::string * p_output, const char * p_seeking );
+    size_t read_integer( bool is_signed, uint64 max_magnitude, uint64 * p_magnitude, bool * p_is_negative, bool * p_is_overflow );
+    bool read_float_value( double * p_float, bool is_sci );
+    bool read_fixed_width_uint( uint64 max_value, size_t n_digits, uint64 * p_value );
+    bool read_qstring_ref( string_ref * p_string, char delimiter, bool is_in_place );
+    size_t read_radix_uint( unsigned int radix_bits, uint64 max_value, size_t min_digits, size_t max_digits, uint64 * p_value );
+    template< typename T >
+    size_t get_radix_uint( T * p_int, unsigned int radix_bits, size_t min_digits, size_t max_digits )
+    {
+        uint64 value;
+        size_t n_read = read_radix_uint( radix_bits, static_cast< uint64 >( (std::numeric_limits< T >::max)() ), min_digits, max_digits, &value );
+        if( n_read > 0 )
+            *p_int = static_cast< T >( value );
+        return n_read;
+    }
 
 public:
     dsl_pa( reader & r_reader_in ) : r_reader( r_reader_in ), p_accumulator( 0 ) {}
@@ -169,10 +323,65 @@ public:
     bool /*is_parsed*/ get_bool( bool * p_bool );
     size_t /*num chars read*/ get_int( std::string * p_num );
     size_t /*num chars read*/ read_int( std::string * p_num );
+    // get_int( int * ) and get_uint( unsigned int * ) use get_integer(), so
+    // if the value doesn't fit in an int (or, for get_uint(), in a 64-bit
+    // int) they return 0 and leave the input location unchanged.  Earlier
+    // versions consumed the digits and stored an out of range result.
     size_t /*num chars read*/ get_int( int * p_int );
     size_t /*num chars read*/ get_uint( std::string * p_num );
     size_t /*num chars read*/ read_uint( std::string * p_num );
     size_t /*num chars read*/ get_uint( unsigned int * p_int );
+    // get_integer() reads a decimal integer directly into *p_int without
+    // allocating.  Signed types accept a leading '+' or '-'.  If there are no
+    // digits, or the value doesn't fit in T, 0 is returned and the input
+    // location is unchanged.  *p_is_overflow records whether the latter was
+    // the cause.
+    template< typename T >
+    size_t /*num chars read*/ get_integer( T * p_int, bool * p_is_overflow = 0 )
+    {
+        uint64 magnitude;
+        bool is_negative;
+        size_t n_read = read_integer( std::numeric_limits< T >::is_signed,
+                                        static_cast< uint64 >( (std::numeric_limits< T >::max)() ),
+                                        &magnitude, &is_negative, p_is_overflow );
+        if( n_read > 0 )
+            *p_int = (is_negative && magnitude != 0) ?
+                        static_cast< T >( -static_cast< T >( magnitude - 1 ) - 1 ) :   // Avoids overflow at min()
+                        static_cast< T >( magnitude );
+        return n_read;
+    }
+    // get_fixed_width_uint() reads exactly n_digits decimal digits, such as
+    // the fields of an ISO date, regardless of what follows them.  If there
+    // are fewer digits, or the value doesn't fit in T, false is returned
+    // and the input location is unchanged.
+    template< typename T >
+    bool /*is_parsed*/ get_fixed_width_uint( T * p_int, size_t n_digits )
+    {
+        uint64 value;
+        if( ! read_fixed_width_uint( static_cast< uint64 >( (std::numeric_limits< T >::max)() ), n_digits, &value ) )
+            return false;
+        *p_int = static_cast< T >( value );
+        return true;
+    }
+    // get_hex(), get_oct() and get_bin() read an unsigned integer in base 16
+    // (either case), 8 or 2 directly into *p_int.  At most max_digits digits
+    // are read.  If fewer than min_digits are found, or the value doesn't fit
+    // in T, 0 is returned and the input location is unchanged.
+    template< typename T >
+    size_t /*num chars read*/ get_hex( T * p_int, size_t min_digits = 1, size_t max_digits = unbounded )
+    {
+        return get_radix_uint( p_int, 4, min_digits, max_digits );
+    }
+    template< typename T >
+    size_t /*num chars read*/ get_oct( T * p_int, size_t min_digits = 1, size_t max_digits = unbounded )
+    {
+        return get_radix_uint( p_int, 3, min_digits, max_digits );
+    }
+    template< typename T >
+    size_t /*num chars read*/ get_bin( T * p_int, size_t min_digits = 1, size_t max_digits = unbounded )
+    {
+        return get_radix_uint( p_int, 1, min_digits, max_digits );
+    }
     bool /*is_parsed*/ get_float( std::string * p_num );
     bool /*is_parsed*/ read_float( std::string * p_num );
     bool /*is_parsed*/ get_float( double * p_float );
@@ -182,6 +391,8 @@ public:
     bool /*is_parsed*/ get_sci_float( double * p_float );
     bool /*is_parsed*/ get_sci_float( float * p_float );
     bool /*is_parsed*/ get_qstring_contents( std::string * p_string, char delimiter = '"' );   // Assumes opening quotes already read. Does NOT consume closing quotes.
+    bool /*is_parsed*/ get_qstring_contents( string_ref * p_string, char delimiter = '"' );   // Refers to input in place if possible. See string_ref
+    bool /*is_parsed*/ get_qstring_contents_in_place( string_ref * p_string, char delimiter = '"' );   // May unescape into the input. See below
 
     // The primary workhorse functions
     // These get...() functions clear the output string before reading the input
@@ -193,6 +404,22 @@ public:
     size_t get_until( std::string * p_output, const alphabet & r_alphabet, char escape_char, size_t max_chars );
     size_t get( std::string * p_output, mutator & r_mutator );
 
+    // These get...() functions refer to the input in place where possible
+    // rather than copying it. See string_ref
+    size_t /*num chars read*/ get( string_ref * p_output, const alphabet & r_alphabet );
+    size_t get( string_ref * p_output, const alphabet & r_alphabet, size_t max_chars );
+    size_t get_until( string_ref * p_output, const alphabet & r_alphabet );
+    size_t get_bounded_until( string_ref * p_output, const alphabet & r_alphabet, size_t max_chars );
+
+    // These ..._in_place() functions write the unescaped result back into
+    // the input where the reader allows it (see reader_mutable_mem_buf), and
+    // refer to it there.  The input that has been read is overwritten, so it
+    // must not be read again by rewinding to a location before it.  With
+    // other readers they behave as the string_ref functions above.
+    // get_qstring_contents_in_place() only modifies the input if the
+    // q-string is valid.
+    size_t get_escaped_until_in_place( string_ref * p_output, const alphabet & r_alphabet, char escape_char );
+
     // These read...() functions DO NOT clear the output string before reading the input
     size_t /*num chars read*/ read( std::string * p_output, const alphabet & r_alphabet );
     size_t read( std::string * p_output, const alphabet & r_alphabet, size_t max_chars );
@@ -219,6 +446,14 @@ public:
     bool read_fixed( std::string * p_output, const char * p_seeking );
     bool read_ifixed( std::string * p_output, const char * p_seeking );
 
+    // fixed_one_of() reads the longest keyword in r_keywords found at the
+    // current input location and, if p_index is not null, sets *p_index to
+    // the keyword's index.  If none match the input location is unchanged.
+    // The get and read versions output the text as it appeared in the input.
+    bool fixed_one_of( const keyword_set & r_keywords, size_t * p_index = 0 );
+    bool get_fixed_one_of( std::string * p_output, const keyword_set & r_keywords, size_t * p_index = 0 );
+    bool read_fixed_one_of( std::string * p_output, const keyword_set & r_keywords, size_t * p_index = 0 );
+
     friend class accumulator_deferred;      // Use an instance of the accumulator class to store accumulated input
     bool accumulate( char c );
     bool accumulate( const alphabet & r_alphabet ); // If next input character is in alphabet then add it to the active accumulator
@@ -227,6 +462,8 @@ public:
     bool accumulator_append( const char * s );  // Append the string s to the active accumulator
     bool accumulator_append( const std::string & r_s );  // Append the string r_s to the active accumulator
     bool accumulator_append( const accumulator_deferred & r_a );  // Append another accumulator to the active accumulator
+    bool accumulator_append( const char * p_begin, const char * p_end );  // Append the chars [p_begin, p_end) to the active accumulator
+    bool accumulator_append_input( const char * p_begin, const char * p_end );  // As above, for chars of the input obtained via reader::get_span()
     bool accumulator_to_previous();  // Append current accummulator content to previous accummulator. Returns true.
     bool accumulate_atomic( bool is_valid );  // Append current accummulator content to previous accummulator if is_valid is true. Returns is_valid value.
 
@@ -383,13 +620,31 @@ class accumulator_deferred      // Control access to dsl_pa::p_accumulator so it
 private:
     dsl_pa * p_dsl_pa;
     accumulator_deferred * p_previous_accumulator;
-    std::string my_accumulator;
+
+    // Where the reader's input is stable (see reader::is_input_stable()),
+    // chars accumulated from the input are recorded as the span
+    // [p_span_begin, p_span_end) of the input that follows my_accumulator,
+    // and only copied when get() is called or a char that doesn't continue
+    // the span is appended.  This makes appending one accumulator to
+    // another cheap.
+    mutable std::string my_accumulator;
+    mutable const char * p_span_begin;
+    mutable const char * p_span_end;
+
+    void materialize() const
+    {
+        if( p_span_begin != p_span_end )
+            my_accumulator.append( p_span_begin, p_span_end );
+        p_span_begin = p_span_end = 0;
+    }
 
 public:
     accumulator_deferred( dsl_pa * p_dsl_pa_in )
         :
         p_dsl_pa( p_dsl_pa_in ),
-        p_previous_accumulator( p_dsl_pa_in->p_accumulator )
+        p_previous_accumulator( p_dsl_pa_in->p_accumulator ),
+        p_span_begin( 0 ),
+        p_span_end( 0 )
     {
     }
     ~accumulator_deferred() { previous(); }
@@ -397,28 +652,52 @@ public:
     bool select() { p_dsl_pa->p_accumulator = this; return true; }
     bool previous() { p_dsl_pa->p_accumulator = p_previous_accumulator; return true; }
     bool none() { p_dsl_pa->p_accumulator = 0; return true; }
-    bool clear() { my_accumulator.clear(); return true; }
+    bool clear() { my_accumulator.clear(); p_span_begin = p_span_end = 0; return true; }
     bool select_and_clear() { select(); return clear(); }
 
-    bool append( char c ) { my_accumulator += c; return true; }
-    bool append( const char * s ) { my_accumulator += s; return true; }
-    bool append( const std::string & r_s ) { my_accumulator += r_s; return true; }
-    bool append( const accumulator_deferred & r_a ) { my_accumulator += r_a.my_accumulator; return true; }
-    bool append_to_previous() const { if( p_previous_accumulator ) p_previous_accumulator->append( my_accumulator ); return true; }
-
-    const std::string & get() const { return my_accumulator; }
-    int to_int() const { return atoi( my_accumulator.c_str() ); }
-    unsigned int  to_uint() const { return static_cast<unsigned int>( strtoul( my_accumulator.c_str(), 0, 10 ) ); }
-    int64 to_int64() const;
-    uint64 to_uint64() const;
-    double to_float() const { return atof( my_accumulator.c_str() ); }
+    bool append( char c ) { materialize(); my_accumulator += c; return true; }
+    bool append( const char * s ) { materialize(); my_accumulator += s; return true; }
+    bool append( const std::string & r_s ) { materialize(); my_accumulator += r_s; return true; }
+    bool append( const accumulator_deferred & r_a )
+    {
+        if( r_a.my_accumulator.empty() )
+            return append_input( r_a.p_span_begin, r_a.p_span_end );
+        return append( r_a.get() );
+    }
+    bool append( const char * p_begin, const char * p_end ) { materialize(); my_accumulator.append( p_begin, p_end ); return true; }
+    bool append_input( const char * p_begin, const char * p_end )  // [p_begin, p_end) must be stable input
+    {
+        if( p_begin == p_end )
+            return true;
+        if( p_begin != p_span_end || p_span_begin == p_span_end )
+        {
+            materialize();
+            p_span_begin = p_begin;
+        }
+        p_span_end = p_end;
+        return true;
+    }
+    bool append_to_previous() const { if( p_previous_accumulator ) p_previous_accumulator->append( *this ); return true; }
+
+    const std::string & get() const { materialize(); return my_accumulator; }
+    int to_int() const { return atoi( get().c_str() ); }
+    unsigned int  to_uint() const { return static_cast<unsigned int>( strtoul( get().c_str(), 0, 10 ) ); }
+    // to_int64() and to_uint64() return 0 if the accumulated integer doesn't
+    // fit in the type, which for to_uint64() includes a negative value.  The
+    // versions that take a pointer, and the corresponding put_in()s, return
+    // false instead and leave the destination unchanged.
+    int64 to_int64() const { int64 value = 0; to_int64( &value ); return value; }
+    uint64 to_uint64() const { uint64 value = 0; to_uint64( &value ); return value; }
+    bool /*is_in_range*/ to_int64( int64 * p_value ) const;
+    bool /*is_in_range*/ to_uint64( uint64 * p_value ) const;
+    double to_float() const { return atof( get().c_str() ); }
     // bool to_bool() const = delete - Textual definitions of Boolean are very application specific so not supported here
 
     bool put_in( std::string & r_place_where ) const { r_place_where = get(); return true; }
     bool put_in( int & r_place_where ) const { r_place_where = to_int(); return true; }
     bool put_in( unsigned int & r_place_where ) const { r_place_where = to_uint(); return true; }
-    bool put_in( int64 & r_place_where ) const { r_place_where = to_int64(); return true; }
-    bool put_in( uint64 & r_place_where ) const { r_place_where = to_uint64(); return true; }
+    bool put_in( int64 & r_place_where ) const { return to_int64( &r_place_where ); }
+    bool put_in( uint64 & r_place_where ) const { return to_uint64( &r_place_where ); }
     bool put_in( float & r_place_where ) const { r_place_where = static_cast<float>(to_float()); return true; }
     bool put_in( double & r_place_where ) const { r_place_where = to_float(); return true; }
 };
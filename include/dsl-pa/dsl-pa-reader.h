@@ -43,35 +43,66 @@
 
 #include <string>
 #include <vector>
-#include <stack>
 #include <fstream>
+#include <cstring>
 
 #include "cl-utils/history-buffer.h"
 
 namespace cl {
 
+// Location frames are kept in vectors and hold a fixed amount of state so
+// that location_push() doesn't allocate in the common case.
+
 class unget_buffer_with_stack
 {
 private:
-    typedef std::stack< char > unget_buffer_t;
+    struct frame
+    {
+        size_t saved_begin;     // Index into saved of this frame's ungot chars
+        size_t saved_size;
 
-    unget_buffer_t unget_buffer;
-    std::stack< unget_buffer_t > stack;
+        frame( size_t saved_begin_in, size_t saved_size_in )
+            :
+            saved_begin( saved_begin_in ),
+            saved_size( saved_size_in )
+        {}
+    };
+
+    std::vector< char > unget_buffer;   // Top of the unget stack is at the back
+    std::vector< char > saved;          // Ungot chars of all frames, bottom frame first
+    std::vector< frame > stack;
+
+    void save()
+    {
+        stack.push_back( frame( saved.size(), unget_buffer.size() ) );
+        saved.insert( saved.end(), unget_buffer.begin(), unget_buffer.end() );
+    }
 
 public:
-    void unget( char c ) { unget_buffer.push( c ); }
-    char reget() { char c = unget_buffer.top(); unget_buffer.pop(); return c; }
+    void unget( char c ) { unget_buffer.push_back( c ); }
+    char reget() { char c = unget_buffer.back(); unget_buffer.pop_back(); return c; }
     bool empty() const { return unget_buffer.empty(); }
+    size_t size() const { return unget_buffer.size(); }
 
-    void push()
+    void push() { save(); }
+    void revise() { if( ! stack.empty() ) { pop(); save(); } }
+    void top()
     {
-        // Push empty object to avoid multiple copies of unget_buffer
-        stack.push( unget_buffer_t() );
-        stack.top() = unget_buffer;
+        if( ! stack.empty() )
+        {
+            const frame & r_frame = stack.back();
+            unget_buffer.assign( saved.begin() + r_frame.saved_begin,
+                                    saved.begin() + r_frame.saved_begin + r_frame.saved_size );
+        }
+    }
+    void pop()
+    {
+        if( ! stack.empty() )
+        {
+            saved.resize( stack.back().saved_begin );
+            stack.pop_back();
+        }
     }
-    void revise() { if( ! stack.empty() ) stack.top() = unget_buffer; }
-    void top() { if( ! stack.empty() ) unget_buffer = stack.top(); }
-    void pop() { if( ! stack.empty() ) stack.pop(); }
 };
 
 class line_counter_with_stack
@@ -84,35 +115,98 @@ private:
     {
         int line_number;
         int column_number;
-
-        position() : line_number( 0 ), column_number( 0 ) {}
-        position( int line_number_in, int column_number_in )
-            : line_number( line_number_in ), column_number( column_number_in )
+        char last_nl_char;  // Part of the position so that going back and re-reading a newline counts it the same way
+
+        position() : line_number( 0 ), column_number( 0 ), last_nl_char( '\0' ) {}
+        position( int line_number_in, int column_number_in, char last_nl_char_in )
+            :
+            line_number( line_number_in ),
+            column_number( column_number_in ),
+            last_nl_char( last_nl_char_in )
         {}
     };
 
     struct stack_item
     {
         clutils::HistoryBuffer< position, 10 > history_buffer;
-        char last_nl_char;
-        stack_item() : last_nl_char( '\0' ) {}
         // stack_item & operator = ( const stack_item & rhs ) = default;
     };
     stack_item current;
-    std::stack< stack_item > stack;
 
-    void set_position( int line_number, int column_number )
+    // A frame records the current position and up to frame_depth - 1 of the
+    // positions before it, so that a few of the chars most recently got
+    // before the location was recorded can still be ungot after returning
+    // to it.  See reader::unget().
+    enum { frame_depth = 10 };   // As many as history_buffer keeps
+    struct frame
+    {
+        position positions[frame_depth];    // Oldest first, current last
+        size_t n_positions;
+    };
+    std::vector< frame > stack;
+
+    void set_position( int line_number, int column_number, char last_nl_char )
+    {
+        current.history_buffer.push( position( line_number, column_number, last_nl_char ) );
+    }
+    void save( frame * p_frame )
     {
-        current.history_buffer.push( position( line_number, column_number ) );
+        size_t n_back = 0;
+        while( n_back < static_cast< size_t >( frame_depth - 1 ) && current.history_buffer.has_back() )
+        {
+            current.history_buffer.go_back();
+            ++n_back;
+        }
+        p_frame->n_positions = n_back + 1;
+        for( size_t i = 0; ; ++i )
+        {
+            p_frame->positions[i] = current.history_buffer.get();
+            if( i == n_back )
+                break;
+            current.history_buffer.go_frwd();
+        }
     }
 
 public:
     line_counter_with_stack()
     {
-        set_position( 1, 0 );
+        set_position( 1, 0, '\0' );
     }
 
-    void got_char( char c );
+    void got_char( char c )
+    {
+        if( current.history_buffer.has_frwd() )
+        {
+            // The reader's source stepped back for an unget() (see
+            // reader::source_unget()), so c is the char that was ungot
+            current.history_buffer.go_frwd();
+            return;
+        }
+
+        int line_number = get_line_number();
+        int column_number = get_column_number();
+        char last_nl_char = current.history_buffer.get().last_nl_char;
+
+        if( c == '\r' || c == '\n' )
+        {
+            column_number = 0;
+            if( last_nl_char == '\0' || last_nl_char == c )
+                ++line_number;
+
+             if( last_nl_char != '\0' )    // See Blank_line_counting in dsl-pa-reader.cpp
+                last_nl_char = '\0';
+             else
+                last_nl_char = c;
+        }
+        else
+        {
+            ++column_number;
+
+            last_nl_char = '\0';
+        }
+
+        set_position( line_number, column_number, last_nl_char );
+    }
     void ungot_char( char /*c*/ )
     {
         if( current.history_buffer.has_back() )
@@ -133,19 +227,106 @@ public:
         // Tracking column numbers not implemented by this class
         return current.history_buffer.get().column_number;
     }
+    char get_last_nl_char() const
+    {
+        return current.history_buffer.get().last_nl_char;
+    }
+    void reset( int line_number, int column_number, char last_nl_char )
+    {
+        current.history_buffer.clear();
+        set_position( line_number, column_number, last_nl_char );
+    }
 
-    void push() { stack.push( current ); }
-    void revise() { if( ! stack.empty() ) stack.top() = current; }
-    void top() { if( ! stack.empty() ) current = stack.top(); }
-    void pop() { if( ! stack.empty() ) stack.pop(); }
+    void push() { stack.push_back( frame() ); save( &stack.back() ); }
+    void revise() { if( ! stack.empty() ) save( &stack.back() ); }
+    void top()
+    {
+        if( ! stack.empty() )
+        {
+            const frame & r_frame = stack.back();
+            current.history_buffer.clear();
+            for( size_t i = 0; i < r_frame.n_positions; ++i )
+                current.history_buffer.push( r_frame.positions[i] );
+        }
+    }
+    void pop() { if( ! stack.empty() ) stack.pop_back(); }
+};
+
+// lazy_line_counter works out line and column numbers on demand, applying
+// the same rules as line_counter_with_stack.  It builds an index of the
+// newlines in the input as far as the furthest position asked for, so
+// looking up a position is a binary search of the index, and the input is
+// only scanned once no matter how many positions are asked for.
+
+class lazy_line_counter
+{
+private:
+    struct position
+    {
+        size_t offset;
+        int line_number;
+        int column_number;
+        char last_nl_char;
+
+        position() : offset( 0 ), line_number( 1 ), column_number( 0 ), last_nl_char( '\0' ) {}
+    };
+
+    struct newline
+    {
+        size_t offset;      // Offset of the newline char
+        int line_number;    // Line number after the newline char
+        char last_nl_char;  // last_nl_char after the newline char
+    };
+
+    position base;          // Position when lazy counting started
+    mutable std::vector< newline > newline_index;
+    mutable size_t index_end;   // Offset up to which newline_index is complete
+
+    void extend_index( const char * p_input, size_t offset ) const;
+    position locate( const char * p_input, size_t offset ) const;
+
+public:
+    lazy_line_counter() : index_end( 0 ) {}
+
+    void start( size_t offset, int line_number, int column_number, char last_nl_char )
+    {
+        base.offset = offset;
+        base.line_number = line_number;
+        base.column_number = column_number;
+        base.last_nl_char = last_nl_char;
+        newline_index.clear();
+        index_end = offset;
+    }
+
+    int get_line_number( const char * p_input, size_t offset ) const
+    {
+        return locate( p_input, offset ).line_number;
+    }
+    int get_column_number( const char * p_input, size_t offset ) const
+    {
+        return locate( p_input, offset ).column_number;
+    }
+    char get_last_nl_char( const char * p_input, size_t offset ) const
+    {
+        return locate( p_input, offset ).last_nl_char;
+    }
+    // Index the newlines up to offset now, e.g. before the input is modified
+    void index_to( const char * p_input, size_t offset ) const
+    {
+        if( offset > index_end )
+            extend_index( p_input, offset );
+    }
 };
 
 class reader
 {
 private:
     line_counter_with_stack line_counter;
+    lazy_line_counter lazy_counter;
     unget_buffer_with_stack unget_buffer;
     char current_char;
+    const char * p_span;
+    bool is_lazy;
 
     virtual char get_next_input() = 0;
 
@@ -154,23 +335,67 @@ private:
     virtual void source_location_top() = 0;
     virtual void source_location_pop() = 0;
 
+    // Optional contiguous input support.  Readers that hold their input in a
+    // buffer can return the unread part of the buffer via source_span() and
+    // mark the first n chars of it as read via source_consume().
+    // source_unget() allows a reader to step back over the char it most
+    // recently returned, so that unget() doesn't need the unget buffer.
+    virtual bool source_span( const char ** /*pp_begin*/, const char ** /*pp_end*/ ) { return false; }
+    virtual void source_consume( size_t /*n*/ ) {}
+    virtual bool source_unget( char /*c*/ ) { return false; }
+
+    // Optional lazy line counting support.  Readers that hold all of their
+    // input in memory can return the start of the input and the location of
+    // the next char to be read.
+    virtual bool source_input( const char ** /*pp_begin*/, const char ** /*pp_current*/ ) const { return false; }
+
+    // Optional in-place modification support.  Readers whose input may be
+    // written to return a writable pointer to the input char at p_input.
+    virtual char * source_mutable( const char * /*p_input*/ ) { return 0; }
+
+    size_t lazy_offset( const char ** pp_begin ) const;
+
 public:
     enum { R_EOI = 0 }; // Constant for "Reader End Of Input"
 
-    reader() : current_char( R_EOI ) {}
+    reader() : current_char( R_EOI ), p_span( 0 ), is_lazy( false ) {}
     virtual ~reader() {}
 
     virtual bool is_open() const { return true; }
 
+    // is_input_stable() returns true if the reader holds all of its input in
+    // memory that stays put for the lifetime of the reader (e.g.
+    // reader_string, reader_mem_buf and reader_mmap).  Pointers obtained
+    // via get_span() from such a reader remain valid after the input has
+    // been consumed, so that tokens can be referred to in place.
+    bool is_input_stable() const
+    {
+        const char * p_begin, * p_current;
+        return source_input( &p_begin, &p_current );
+    }
+
+    // mutable_input() returns a writable pointer to the input char at
+    // p_input (typically obtained from get_span()) if the reader allows its
+    // input to be modified (e.g. reader_mutable_mem_buf), and 0 otherwise.
+    // With lazy line counting, the newlines in the rest of the input are
+    // indexed first, so that overwriting the input doesn't change the line
+    // and column numbers.
+    char * mutable_input( const char * p_input );
+
     char get();
     char current() const { return current_char; }
+    // After location_top(), the line and column numbers follow up to 9
+    // unget()s back past the returned to location, as they do without
+    // location_top(), although any number of chars can still be ungot.
     void unget() { unget( current() ); }    // Unget with argument ungets current char
     void unget( char c )
     {
         if( c != R_EOI )
         {
-            line_counter.ungot_char( c );
-            unget_buffer.unget( c );
+            if( ! is_lazy )
+                line_counter.ungot_char( c );
+            if( ! unget_buffer.empty() || ! source_unget( c ) )
+                unget_buffer.unget( c );
         }
     }
     char peek() { get(); unget(); return current(); }
@@ -190,6 +415,18 @@ public:
         return peek() == R_EOI;
     }
 
+    // get_span() gives access to the block of input that immediately follows
+    // the current location, without having to get() each char in turn.  It
+    // returns false if the reader doesn't support contiguous access, there
+    // are ungot chars pending or the end of input has been reached.  It does
+    // not change the current location.  Call consume() to mark the first n
+    // chars of the most recently returned span as read.  e.g.:
+    //      const char * p_begin, * p_end;
+    //      if( my_reader.get_span( &p_begin, &p_end ) )
+    //          my_reader.consume( std::find( p_begin, p_end, ';' ) - p_begin );
+    bool get_span( const char ** pp_begin, const char ** pp_end );
+    void consume( size_t n );
+
     // Recording input locations and rewinding is based on stack operations.
     // i.e. you can call location_top() many times and the return location
     // won't be deleted.  When the recorded location is no longer required,
@@ -223,50 +460,38 @@ public:
         line_counter.pop();
     }
 
-    int get_line_number() const { return line_counter.get_line_number(); }
-    int get_column_number() const { return line_counter.get_column_number(); }
-};
-
-class reader_string : public reader
-{
-private:
-    const char * p_input;
-    std::stack< const char * > location_buffer;
-
-public:
-    reader_string( const char * p_input_in )
-        :
-        p_input( p_input_in )
-    {}
-    reader_string( const std::string & r_input_in )
-        :
-        p_input( r_input_in.c_str() )
-    {}
-
-    virtual char get_next_input()
-    {
-        if( *p_input )
-            return *p_input++;
-
-        return reader::R_EOI;
-    }
+    // By default the line and column numbers are updated as each char is
+    // read.  With lazy line counting only the reader's offset into the input
+    // is tracked, and the line and column numbers are worked out when they
+    // are asked for.  This is useful when line numbers are only needed for
+    // reporting errors.  Only readers that hold all of their input in memory
+    // (e.g. reader_string, reader_mem_buf and reader_mmap) support lazy line
+    // counting, and set_lazy_line_counting() returns false for other readers.
+    // Lazy line counting should be changed when no locations are recorded.
+    // In lazy mode, reading past the end of the input does not advance the
+    // column number.
+    bool set_lazy_line_counting( bool is_lazy_in );
+    bool is_lazy_line_counting() const { return is_lazy; }
 
-    virtual void source_location_push()
-    {
-        location_buffer.push( p_input );
-    }
-    virtual void source_location_revise()
-    {
-        location_buffer.top() = p_input;
-    }
-    virtual void source_location_top()
+    int get_line_number() const
     {
-        if( ! location_buffer.empty() )
-            p_input = location_buffer.top();
+        if( is_lazy )
+        {
+            const char * p_begin;
+            size_t offset = lazy_offset( &p_begin );
+            return lazy_counter.get_line_number( p_begin, offset );
+        }
+        return line_counter.get_line_number();
     }
-    virtual void source_location_pop()
+    int get_column_number() const
     {
-        location_buffer.pop();
+        if( is_lazy )
+        {
+            const char * p_begin;
+            size_t offset = lazy_offset( &p_begin );
+            return lazy_counter.get_column_number( p_begin, offset );
+        }
+        return line_counter.get_column_number();
     }
 };
 
@@ -274,7 +499,7 @@ class reader_mem_buf : public reader
 {
 private:
     const char * p_begin, * p_current, * p_end;
-    std::stack< const char * > location_buffer;
+    std::vector< const char * > location_buffer;
 
 public:
     reader_mem_buf( const char * p_begin_in, size_t size )
@@ -290,6 +515,16 @@ public:
         p_end( &r_in[0] + r_in.size() )
     {}
 
+protected:
+    void set_buffer( const char * p_begin_in, size_t size )
+    {
+        p_begin = p_current = p_begin_in;
+        p_end = p_begin_in + size;
+        location_buffer.clear();
+    }
+
+public:
+
     virtual char get_next_input()
     {
         if( p_current != p_end )
@@ -298,72 +533,275 @@ public:
         return reader::R_EOI;
     }
 
+    virtual bool source_span( const char ** pp_begin, const char ** pp_end )
+    {
+        *pp_begin = p_current;
+        *pp_end = p_end;
+        return p_current != p_end;
+    }
+    virtual void source_consume( size_t n )
+    {
+        p_current += n;
+    }
+    virtual bool source_unget( char c )
+    {
+        if( p_current != p_begin && *(p_current - 1) == c )
+        {
+            --p_current;
+            return true;
+        }
+        return false;
+    }
+    virtual bool source_input( const char ** pp_begin, const char ** pp_current ) const
+    {
+        *pp_begin = p_begin;
+        *pp_current = p_current;
+        return true;
+    }
+
     virtual void source_location_push()
     {
-        location_buffer.push( p_current );
+        location_buffer.push_back( p_current );
     }
     virtual void source_location_revise()
     {
-        location_buffer.top() = p_current;
+        location_buffer.back() = p_current;
     }
     virtual void source_location_top()
     {
         if( ! location_buffer.empty() )
-            p_current = location_buffer.top();
+            p_current = location_buffer.back();
     }
     virtual void source_location_pop()
     {
-        location_buffer.pop();
+        location_buffer.pop_back();
     }
 };
 
-class reader_file : public reader
+class reader_string : public reader_mem_buf
+{
+public:
+    reader_string( const char * p_input_in )
+        :
+        reader_mem_buf( p_input_in, strlen( p_input_in ) )
+    {}
+    reader_string( const std::string & r_input_in )
+        :
+        reader_mem_buf( r_input_in.c_str(), strlen( r_input_in.c_str() ) )
+    {}
+};
+
+// reader_mutable_mem_buf reads from a buffer that the caller allows to be
+// modified, such as a vector of data collected from a socket.  The
+// ..._in_place() methods of dsl_pa use this to write unescaped input back
+// into the part of the buffer that has already been read, so that no
+// additional memory is required.  The buffer must outlive the reader.
+
+class reader_mutable_mem_buf : public reader_mem_buf
 {
 private:
-    std::ifstream fin;
-    std::stack< std::ifstream::pos_type > location_buffer;
+    char * p_mutable_begin;
+    char * p_mutable_end;
 
 public:
-    reader_file( const char * p_input_in )
+    reader_mutable_mem_buf( char * p_begin_in, size_t size )
         :
-        fin( p_input_in, std::ios::binary )
+        reader_mem_buf( p_begin_in, size ),
+        p_mutable_begin( p_begin_in ),
+        p_mutable_end( p_begin_in + size )
+    {}
+    reader_mutable_mem_buf( std::vector< char > & r_in )
+        :
+        reader_mem_buf( r_in.empty() ? 0 : &r_in[0], r_in.size() ),
+        p_mutable_begin( r_in.empty() ? 0 : &r_in[0] ),
+        p_mutable_end( p_mutable_begin + r_in.size() )
     {}
 
-    virtual bool is_open() const { return fin.is_open(); }
+    virtual char * source_mutable( const char * p_input )
+    {
+        if( p_input >= p_mutable_begin && p_input < p_mutable_end )
+            return p_mutable_begin + (p_input - p_mutable_begin);
+        return 0;
+    }
+};
+
+// reader_mmap maps the whole of a file into memory (read-only) and then
+// behaves like reader_mem_buf.  The advice flags are passed on to the OS
+// (via madvise() where available) to indicate how the file will be read.
+// They can be changed later using advise().  Only regular files can be
+// mapped.  For other inputs, such as devices, FIFOs and /proc files,
+// is_open() returns false so that reader_file or reader_fd can be used
+// instead.
+
+class reader_mmap : public reader_mem_buf
+{
+public:
+    enum { ADVISE_NORMAL = 0, ADVISE_SEQUENTIAL = 1, ADVISE_WILLNEED = 2 };
+
+private:
+    void * p_mapping;
+    size_t mapping_size;
+    bool is_mapped;
+#if defined( _WIN32 )
+    void * h_file;
+    void * h_mapping;
+#endif
+
+    reader_mmap( const reader_mmap & );  // Not copyable
+    reader_mmap & operator = ( const reader_mmap & );
+
+public:
+    reader_mmap( const char * p_file_name, int advice = ADVISE_SEQUENTIAL );
+    ~reader_mmap();
+
+    virtual bool is_open() const { return is_mapped; }
+
+    bool advise( int advice );
+};
+
+// reader_buffered is the base for readers that read their input from a
+// stream in large blocks.  Rewinding to a location that is still in the
+// buffer is just a change of index.  When the buffer is refilled, the input
+// from the oldest outstanding location onwards is retained so that
+// backtracking doesn't require the input to be re-read.  Input is released
+// once no outstanding location refers to it, so memory use is bounded by
+// the deepest live location rather than the length of the input.  If the
+// input can be seeked, large amounts of input aren't retained, and seeking
+// is used if a location that has been released is returned to.
+
+class reader_buffered : public reader
+{
+private:
+    enum { block_size = 65536 };
+
+    std::vector< char > buffer;
+    size_t buffer_pos;              // Index of next char to be read from buffer
+    size_t buffer_size;             // Number of valid chars in buffer
+    std::streamoff buffer_offset;   // Input offset of buffer[0]
+    std::vector< std::streamoff > location_buffer;
+
+    // Derived classes implement these
+    virtual size_t read_input( char * p_buffer, size_t size ) = 0;  // Return number of chars read. 0 at end of input
+    virtual bool is_seekable() const { return false; }
+    virtual void seek_input( std::streamoff /*offset*/ ) {}
+
+    std::streamoff offset() const
+    {
+        return buffer_offset + static_cast< std::streamoff >( buffer_pos );
+    }
+    bool fill_buffer();
+    void seek( std::streamoff offset );
+
+public:
+    reader_buffered()
+        :
+        buffer( block_size ),
+        buffer_pos( 0 ),
+        buffer_size( 0 ),
+        buffer_offset( 0 )
+    {}
 
     virtual char get_next_input()
     {
-        int c = fin.get();
-        if( c == -1 )
+        if( buffer_pos == buffer_size && ! fill_buffer() )
             return reader::R_EOI;
-        return static_cast<char>( c );
+        return buffer[buffer_pos++];
+    }
+
+    virtual bool source_span( const char ** pp_begin, const char ** pp_end )
+    {
+        if( buffer_pos == buffer_size && ! fill_buffer() )
+            return false;
+        *pp_begin = &buffer[0] + buffer_pos;
+        *pp_end = &buffer[0] + buffer_size;
+        return true;
+    }
+    virtual void source_consume( size_t n )
+    {
+        buffer_pos += n;
+    }
+    virtual bool source_unget( char c )
+    {
+        if( buffer_pos != 0 && buffer[buffer_pos - 1] == c )
+        {
+            --buffer_pos;
+            return true;
+        }
+        return false;
     }
 
     virtual void source_location_push()
     {
-        if( fin.eof() )
-            fin.clear();
-        location_buffer.push( fin.tellg() );
+        location_buffer.push_back( offset() );
     }
     virtual void source_location_revise()
     {
-        location_buffer.top() = fin.tellg();
+        location_buffer.back() = offset();
     }
     virtual void source_location_top()
     {
         if( ! location_buffer.empty() )
         {
-            if( fin.eof() )
-                fin.clear();
-            fin.seekg( location_buffer.top() );
+            std::streamoff location = location_buffer.back();
+            if( location >= buffer_offset &&
+                    location <= buffer_offset + static_cast< std::streamoff >( buffer_size ) )
+                buffer_pos = static_cast< size_t >( location - buffer_offset );
+            else
+                seek( location );
         }
     }
     virtual void source_location_pop()
     {
-        location_buffer.pop();
+        location_buffer.pop_back();
     }
 };
 
+// reader_file reads a file.  Input that can't be seeked, such as a named
+// pipe, is also supported.
+
+class reader_file : public reader_buffered
+{
+private:
+    std::ifstream fin;
+    bool is_seekable_input;
+
+    virtual size_t read_input( char * p_buffer, size_t size );
+    virtual bool is_seekable() const { return is_seekable_input; }
+    virtual void seek_input( std::streamoff offset );
+
+public:
+    reader_file( const char * p_input_in );
+
+    virtual bool is_open() const { return fin.is_open(); }
+};
+
+// reader_fd reads from a file descriptor, such as a socket or pipe.  As the
+// input isn't assumed to be seekable, all input from the oldest outstanding
+// location onwards is retained.  If is_owner is true, the file descriptor
+// is closed when the reader is destroyed.
+
+class reader_fd : public reader_buffered
+{
+private:
+    int fd;
+    bool is_owner;
+
+    reader_fd( const reader_fd & );  // Not copyable
+    reader_fd & operator = ( const reader_fd & );
+
+    virtual size_t read_input( char * p_buffer, size_t size );
+
+public:
+    reader_fd( int fd_in, bool is_owner_in = false )
+        :
+        fd( fd_in ),
+        is_owner( is_owner_in )
+    {}
+    ~reader_fd();
+
+    virtual bool is_open() const { return fd >= 0; }
+};
+
 } // End of namespace cl
 
 #endif // CL_DSL_PA_READER
@@ -40,215 +40,368 @@
 
 #include "dsl-pa/dsl-pa-reader.h"
 
+#include "dsl-pa-simd.h"
+
+#include <string>
+
+#if __cplusplus >= 201103L
+    #include <atomic>
+    #include <mutex>
+#else
+    #if defined( _WIN32 )
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+    #else
+        #include <pthread.h>
+    #endif
+#endif
+
 namespace cl {
 
 using namespace cl::alphabet_helpers;
 
-char_map::char_map()
+namespace {
+
+using namespace cl::simd_helpers;
+
+// The scanners test whole blocks of chars against a char_map's bits.  They
+// return a pointer to the first char whose membership is is_set_sought, or
+// to the start of the remaining chars that are too few to make a block.
+// The caller tests the remaining chars one at a time.
+
+typedef const char * (*scanner_t)( const unsigned char * p_bits,
+                                    const char * p_c, const char * p_end, bool is_set_sought );
+
+const char * scan_none( const unsigned char * /*p_bits*/,
+                        const char * p_c, const char * /*p_end*/, bool /*is_set_sought*/ )
 {
-    clear();
+    return p_c;
 }
 
-void char_map::clear()
+#if defined( CL_DSL_PA_X86 )
+CL_DSL_PA_TARGET( "ssse3" )
+const char * scan_ssse3( const unsigned char * p_bits,
+                        const char * p_c, const char * p_end, bool is_set_sought )
 {
-    for( size_t i=0; i<sizeof( char_map_array ); ++i )
-        index[i] = 0;
+    const __m128i table_lo = _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_bits ) );
+    const __m128i table_hi = _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_bits + 16 ) );
+    const __m128i bit_of_hi = _mm_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+    const __m128i nibble_mask = _mm_set1_epi8( 0x0f );
+    const __m128i seven = _mm_set1_epi8( 7 );
+    const unsigned int flip = is_set_sought ? 0 : 0xffff;
+
+    for( ; p_end - p_c >= 16; p_c += 16 )
+    {
+        __m128i block = _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_c ) );
+        __m128i lo = _mm_and_si128( block, nibble_mask );
+        __m128i hi = _mm_and_si128( _mm_srli_epi16( block, 4 ), nibble_mask );
+        __m128i is_hi_half = _mm_cmpgt_epi8( hi, seven );
+        __m128i row = _mm_or_si128(
+                            _mm_andnot_si128( is_hi_half, _mm_shuffle_epi8( table_lo, lo ) ),
+                            _mm_and_si128( is_hi_half, _mm_shuffle_epi8( table_hi, lo ) ) );
+        __m128i bit = _mm_shuffle_epi8( bit_of_hi, hi );
+        __m128i is_set = _mm_cmpeq_epi8( _mm_and_si128( row, bit ), bit );
+        unsigned int mask = static_cast< unsigned int >( _mm_movemask_epi8( is_set ) ) ^ flip;
+        if( mask != 0 )
+            return p_c + first_set_bit( mask );
+    }
+    return p_c;
 }
 
-char_map & char_map::clear( char c )
+CL_DSL_PA_TARGET( "avx2" )
+const char * scan_avx2( const unsigned char * p_bits,
+                        const char * p_c, const char * p_end, bool is_set_sought )
 {
-    index[ char_to_size_t( c ) ] = 0;
-    return *this;
+    const __m256i table_lo = _mm256_broadcastsi128_si256(
+                                _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_bits ) ) );
+    const __m256i table_hi = _mm256_broadcastsi128_si256(
+                                _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_bits + 16 ) ) );
+    const __m256i bit_of_hi = _mm256_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                                1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+    const __m256i nibble_mask = _mm256_set1_epi8( 0x0f );
+    const __m256i seven = _mm256_set1_epi8( 7 );
+    const unsigned int flip = is_set_sought ? 0 : 0xffffffff;
+
+    for( ; p_end - p_c >= 32; p_c += 32 )
+    {
+        __m256i block = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( p_c ) );
+        __m256i lo = _mm256_and_si256( block, nibble_mask );
+        __m256i hi = _mm256_and_si256( _mm256_srli_epi16( block, 4 ), nibble_mask );
+        __m256i is_hi_half = _mm256_cmpgt_epi8( hi, seven );
+        __m256i row = _mm256_blendv_epi8( _mm256_shuffle_epi8( table_lo, lo ),
+                                            _mm256_shuffle_epi8( table_hi, lo ), is_hi_half );
+        __m256i bit = _mm256_shuffle_epi8( bit_of_hi, hi );
+        __m256i is_set = _mm256_cmpeq_epi8( _mm256_and_si256( row, bit ), bit );
+        unsigned int mask = static_cast< unsigned int >( _mm256_movemask_epi8( is_set ) ) ^ flip;
+        if( mask != 0 )
+            return p_c + first_set_bit( mask );
+    }
+    return scan_ssse3( p_bits, p_c, p_end, is_set_sought );
 }
+#endif
 
-char_map & char_map::set( char c )
+scanner_t select_scanner()
 {
-    index[ char_to_size_t( c ) ] = 1;
-    return *this;
+#if defined( CL_DSL_PA_X86 )
+    if( has_avx2() )
+        return scan_avx2;
+    if( has_ssse3() )
+        return scan_ssse3;
+#endif
+    return scan_none;
 }
 
-char_map & char_map::set_range( char start, char end )
+const scanner_t selected_scanner = select_scanner();
+
+inline scanner_t scanner()
 {
-    size_t start_index = char_to_size_t( start );
-    size_t end_index = char_to_size_t( end );
-    for( size_t i = start_index; i <= end_index; ++i )
-        index[i] = 1;
-    return *this;
+    // In case a char_map is used during static initialisation
+    return selected_scanner ? selected_scanner : scan_none;
 }
 
-char_map & char_map::set_inverted_range( char start, char end )
+} // End of anonymous namespace
+
+const char * char_map::find_first_set( const char * p_begin, const char * p_end ) const
 {
-    merge( char_map().set_range( start, end ).invert() );
-    return *this;
+    const char * p_c = scanner()( bits, p_begin, p_end, true );
+    while( p_c != p_end && ! is_set( *p_c ) )
+        ++p_c;
+    return p_c;
 }
 
-char_map & char_map::invert()
+const char * char_map::find_first_not_set( const char * p_begin, const char * p_end ) const
 {
-    for( size_t i=0; i<sizeof( char_map_array ); ++i )
-        index[i] ^= 1;
-    return *this;
+    const char * p_c = scanner()( bits, p_begin, p_end, false );
+    while( p_c != p_end && is_set( *p_c ) )
+        ++p_c;
+    return p_c;
 }
 
-void char_map::merge( const char_map & r_rhs )
+alphabet_flat alphabet::flatten() const
 {
-    for( size_t i=0; i<sizeof( char_map_array ); ++i )
-        index[i] |= r_rhs.index[i];
+    return alphabet_flat( *this );
 }
 
-bool char_map::is_set( char c ) const
+alphabet_flat::alphabet_flat( const alphabet & r_alphabet )
 {
-    return index[ char_to_size_t( c ) ] != 0;
+    for( int i = 0; i < 256; ++i )
+        if( r_alphabet.is_sought( static_cast< char >( i ) ) )
+            wanted_chars.set( static_cast< char >( i ) );
 }
 
-char_map_w::char_map_w()
+size_t alphabet::sought_prefix_length( const char * p_begin, const char * p_end ) const
 {
-    set_range( 'a', 'z' );
-    set_range( 'A', 'Z' );
-    set_range( '0', '9' );
-    set( '_' );
+    if( const char_map * p_char_map = get_char_map() )
+        return p_char_map->find_first_not_set( p_begin, p_end ) - p_begin;
+
+    return sought_prefix_length_by_char( p_begin, p_end );
 }
 
-char_map_d::char_map_d()
+size_t alphabet::unsought_prefix_length( const char * p_begin, const char * p_end ) const
 {
-    set_range( '0', '9' );
+    if( const char_map * p_char_map = get_char_map() )
+        return p_char_map->find_first_set( p_begin, p_end ) - p_begin;
+
+    return unsought_prefix_length_by_char( p_begin, p_end );
 }
 
-char_map_s::char_map_s()
+namespace {
+
+// Interned alphabets are never deleted, so that references to them remain
+// valid for the life of the program.  They are kept in a fixed table of
+// lists that are only ever added to at the front, so looking up a spec
+// that has already been interned takes no lock.  The lock is only taken to
+// add a spec.  The table and the locks can be initialised without running
+// any code, so intern() can be used during static initialisation.
+
+struct interned_char_class
+{
+    interned_char_class( const char * p_spec_in, size_t hash_in, interned_char_class * p_next_in )
+        : spec( p_spec_in ), hash( hash_in ), char_class( p_spec_in ), p_next( p_next_in )
+    {}
+
+    std::string spec;
+    size_t hash;
+    alphabet_char_class char_class;
+    interned_char_class * p_next;
+};
+
+const size_t n_interned_buckets = 64;
+
+#if __cplusplus >= 201103L
+std::atomic< interned_char_class * > interned_buckets[n_interned_buckets];
+
+interned_char_class * load_interned_bucket( size_t i )
 {
-    set( ' ' ).set( '\t' ).set( '\r' ).set( '\n' );
+    return interned_buckets[i].load( std::memory_order_acquire );
 }
 
-char_map_l::char_map_l()
+void store_interned_bucket( size_t i, interned_char_class * p_head )
 {
-    set_range( 'a', 'z' ).set_range( 'A', 'Z' );
+    interned_buckets[i].store( p_head, std::memory_order_release );
 }
 
-alphabet_char_class::alphabet_char_class( const char * p_spec )
+std::mutex interned_char_classes_mutex;
+
+class interned_char_classes_lock
 {
-    bool is_inverted = false;
+private:
+    std::lock_guard< std::mutex > lock;
 
-    if( *p_spec == '^' )
-    {
-        is_inverted = true;
-        ++p_spec;
-    }
+public:
+    interned_char_classes_lock() : lock( interned_char_classes_mutex ) {}
+};
+#elif defined( _WIN32 )
+interned_char_class * volatile interned_buckets[n_interned_buckets];
+
+interned_char_class * load_interned_bucket( size_t i )
+{
+    // Comparing with 0 and exchanging with 0 leaves the bucket as it is
+    return static_cast< interned_char_class * >( InterlockedCompareExchangePointer(
+                        reinterpret_cast< PVOID volatile * >( &interned_buckets[i] ), 0, 0 ) );
+}
 
-    char last_char = (char)0xff;
+void store_interned_bucket( size_t i, interned_char_class * p_head )
+{
+    InterlockedExchangePointer( reinterpret_cast< PVOID volatile * >( &interned_buckets[i] ), p_head );
+}
 
-    for( ; *p_spec != '\0'; ++p_spec )
-    {
-        if( *p_spec == '-' )            // Allow for ranges
-        {
-            if( ! add_range( last_char, *++p_spec ) )
-                return;
-        }
-
-        else if( *p_spec == '\\' || *p_spec == '~' )        // Allow for specials
-        {
-            if( ! add_special_char_class( *++p_spec ) )
-                return;
-        }
-
-        else
-        {
-            wanted_chars.set( last_char = *p_spec );
-        }
-    }
+SRWLOCK interned_char_classes_srwlock = SRWLOCK_INIT;
 
-    if( is_inverted )
-        wanted_chars.invert();
+class interned_char_classes_lock
+{
+public:
+    interned_char_classes_lock() { AcquireSRWLockExclusive( &interned_char_classes_srwlock ); }
+    ~interned_char_classes_lock() { ReleaseSRWLockExclusive( &interned_char_classes_srwlock ); }
+};
+#else
+interned_char_class * interned_buckets[n_interned_buckets];
+
+interned_char_class * load_interned_bucket( size_t i )
+{
+    return __atomic_load_n( &interned_buckets[i], __ATOMIC_ACQUIRE );
+}
 
-    wanted_chars.clear( reader::R_EOI );    // No alphabets want EOI ('\0')
+void store_interned_bucket( size_t i, interned_char_class * p_head )
+{
+    __atomic_store_n( &interned_buckets[i], p_head, __ATOMIC_RELEASE );
 }
 
-bool alphabet_char_class::add_range( char start, char end )
+pthread_mutex_t interned_char_classes_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+class interned_char_classes_lock
 {
-    if( end == '\0' )
-    {
-        wanted_chars.set( '-' );
-        return false;
-    }
-    else
-        wanted_chars.set_range( start, end );   // Don't ++ last_char here incase we have a spec of a-a!
+public:
+    interned_char_classes_lock() { pthread_mutex_lock( &interned_char_classes_mutex ); }
+    ~interned_char_classes_lock() { pthread_mutex_unlock( &interned_char_classes_mutex ); }
+};
+#endif
 
-    return true;
+size_t spec_hash( const char * p_spec )
+{
+    // FNV-1a
+    size_t hash = 2166136261u;
+    for( ; *p_spec; ++p_spec )
+        hash = (hash ^ static_cast< unsigned char >( *p_spec )) * 16777619u;
+    return hash;
 }
 
-bool alphabet_char_class::add_special_char_class( char key )
+const alphabet_char_class * find_interned( const interned_char_class * p_interned, const char * p_spec, size_t hash )
 {
-    switch( key )
-    {
-    case 'w':
-        wanted_chars.merge( char_map_w() );
-    break;
-
-    case 'W':
-        wanted_chars.merge( char_map_w().invert() );
-    break;
-
-    case 'd':
-        wanted_chars.merge( char_map_d() );;
-    break;
-
-    case 'D':
-        wanted_chars.merge( char_map_d().invert() );
-    break;
-
-    case 's':
-        wanted_chars.merge( char_map_s() );
-    break;
-
-    case 'S':
-        wanted_chars.merge( char_map_s().invert() );
-    break;
-
-    case 'l':
-        wanted_chars.merge( char_map_l() );
-    break;
-
-    case 'L':
-        wanted_chars.merge( char_map_l().invert() );
-    break;
-
-    case 'u':
-        wanted_chars.set_range( '\x21', '\xff' );
-    break;
-
-    case '\\':
-        wanted_chars.set( '\\' );
-    break;
-
-    case '~':
-        wanted_chars.set( '~' );
-    break;
-
-    case '-':
-        wanted_chars.set( '-' );
-    break;
-
-    // The following included for completeness.  Instead of ~t you could do \t etc.
-    case 't':
-        wanted_chars.set( '\t' );
-    break;
-
-    case 'r':
-        wanted_chars.set( '\r' );
-    break;
-
-    case 'n':
-        wanted_chars.set( '\n' );
-    break;
-
-    case '\0':
-        wanted_chars.set( '~' );
-        return false;
-    break;
-
-    default:
-        wanted_chars.set( key );
-    }
+    for( ; p_interned; p_interned = p_interned->p_next )
+        if( p_interned->hash == hash && p_interned->spec == p_spec )
+            return &p_interned->char_class;
+    return 0;
+}
+
+} // End of anonymous namespace
 
-    return true;
+const alphabet_char_class & alphabet_char_class::intern( const char * p_spec )
+{
+    size_t hash = spec_hash( p_spec );
+    size_t bucket = hash % n_interned_buckets;
+
+    if( const alphabet_char_class * p_found = find_interned( load_interned_bucket( bucket ), p_spec, hash ) )
+        return *p_found;
+
+    interned_char_classes_lock lock;
+
+    // Another thread may have added the spec since it was looked for
+    interned_char_class * p_head = load_interned_bucket( bucket );
+    if( const alphabet_char_class * p_found = find_interned( p_head, p_spec, hash ) )
+        return *p_found;
+
+    interned_char_class * p_interned = new interned_char_class( p_spec, hash, p_head );
+    store_interned_bucket( bucket, p_interned );
+    return p_interned->char_class;
 }
 
+namespace {
+
+// The char_maps of the common alphabets, laid out as in char_map::bits.
+// Being constant data, they are ready before any code runs.
+
+const unsigned char space_bits[32] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char line_space_bits[32] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char eol_bits[32] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char digit_bits[32] = {
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char hex_bits[32] = {
+    0x08, 0x58, 0x58, 0x58, 0x58, 0x58, 0x58, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char alpha_bits[32] = {
+    0xa0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0x50, 0x50, 0x50, 0x50, 0x50,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char word_first_char_bits[32] = {
+    0xa0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0x50, 0x50, 0x50, 0x50, 0x70,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char word_char_bits[32] = {
+    0xa8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf0, 0x50, 0x50, 0x50, 0x50, 0x70,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char name_char_bits[32] = {
+    0xa8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf8, 0xf0, 0x50, 0x50, 0x54, 0x50, 0x70,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const unsigned char uni_bits[32] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+} // End of anonymous namespace
+
+alphabet_space::alphabet_space() : wanted_chars( space_bits ) {}
+alphabet_line_space::alphabet_line_space() : wanted_chars( line_space_bits ) {}
+alphabet_eol::alphabet_eol() : wanted_chars( eol_bits ) {}
+alphabet_digit::alphabet_digit() : wanted_chars( digit_bits ) {}
+alphabet_hex::alphabet_hex() : wanted_chars( hex_bits ) {}
+alphabet_alpha::alphabet_alpha() : wanted_chars( alpha_bits ) {}
+alphabet_word_first_char::alphabet_word_first_char() : wanted_chars( word_first_char_bits ) {}
+alphabet_word_char::alphabet_word_char() : wanted_chars( word_char_bits ) {}
+alphabet_name_char::alphabet_name_char() : alphabet_word_char( name_char_bits ) {}
+alphabet_uni::alphabet_uni() : wanted_chars( uni_bits ) {}
+
 } // End of namespace cl
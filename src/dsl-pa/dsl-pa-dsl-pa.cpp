@@ -37,8 +37,11 @@
 //----------------------------------------------------------------------------
 
 #include "dsl-pa/dsl-pa-dsl-pa.h"
+#include "dsl-pa-float.h"
+#include "dsl-pa-simd.h"
 
 #include <sstream>
+#include <cstring>
 
 namespace cl {
 
@@ -188,11 +191,7 @@ size_t /*num chars read*/ dsl_pa::read_int( std::string * p_num )
 
 size_t /*num chars read*/ dsl_pa::get_int( int * p_int )
 {
-    std::string input;
-    size_t n_read = read_int( &input );
-    if( n_read > 0 )
-        *p_int = atoi( input.c_str() );
-    return n_read;
+    return get_integer( p_int );
 }
 
 size_t /*num chars read*/ dsl_pa::get_uint( std::string * p_num )
@@ -208,13 +207,169 @@ size_t /*num chars read*/ dsl_pa::read_uint( std::string * p_num )
 
 size_t /*num chars read*/ dsl_pa::get_uint( unsigned int * p_int )
 {
-    std::string input;
-    size_t n_read = get_int( &input );
+    // Historically accepts a sign, with negative values wrapping around.
+    // Use get_integer() for range checked unsigned input.
+    int64 value;
+    size_t n_read = get_integer( &value );
     if( n_read > 0 )
-        sscanf( input.c_str(), "%ud", p_int );
+        *p_int = static_cast< unsigned int >( value );
     return n_read;
 }
 
+namespace {
+
+uint64 load_eight_chars( const char * p )
+{
+    // Little-endian order regardless of platform.  Compilers typically
+    // turn this into a single load.
+    uint64 chars = 0;
+    for( int i = 7; i >= 0; --i )
+        chars = (chars << 8) | static_cast< unsigned char >( p[i] );
+    return chars;
+}
+
+bool is_eight_digits( uint64 chars )
+{
+    // Adding 6 to each byte carries into the high nibble of bytes above '9'
+    const uint64 high_nibbles = 0xF0F0F0F0F0F0F0F0ULL;
+    return ((chars & high_nibbles) |
+            (((chars + 0x0606060606060606ULL) & high_nibbles) >> 4)) == 0x3333333333333333ULL;
+}
+
+uint64 eight_digits_value( uint64 chars )
+{
+    // Combines adjacent digits into pairs, then pairs into fours, then
+    // fours into eight, each step using a multiply of the whole word
+    const uint64 mask = 0x000000FF000000FFULL;
+    const uint64 mul1 = 100 + (1000000ULL << 32);
+    const uint64 mul2 = 1 + (10000ULL << 32);
+    chars -= 0x3030303030303030ULL;
+    chars = (chars * 10) + (chars >> 8);
+    return (((chars & mask) * mul1) + (((chars >> 16) & mask) * mul2)) >> 32;
+}
+
+class integer_accumulator
+{
+    // Accumulates the magnitude of a decimal integer, noting whether it has
+    // exceeded the limit.  Once it has, further digits are counted but
+    // otherwise ignored.
+private:
+    uint64 limit;
+    uint64 magnitude;
+    size_t n_digits;
+    bool is_overflow_set;
+
+public:
+    integer_accumulator( uint64 limit_in )
+        : limit( limit_in ), magnitude( 0 ), n_digits( 0 ), is_overflow_set( false )
+    {}
+
+    void add( char c )
+    {
+        unsigned int digit = c - '0';
+        if( magnitude > (limit - digit) / 10 )
+            is_overflow_set = true;
+        else if( ! is_overflow_set )
+            magnitude = magnitude * 10 + digit;
+        ++n_digits;
+    }
+    bool add_eight( const char * p )
+    {
+        // Adds the eight chars at p if they are all digits and won't
+        // overflow.  Otherwise returns false so that they can be handled
+        // individually.
+        const uint64 ten_to_the_8 = 100000000;
+        uint64 chars = load_eight_chars( p );
+        if( is_overflow_set || ! is_eight_digits( chars ) )
+            return false;
+        uint64 value = eight_digits_value( chars );
+        if( value > limit || magnitude > (limit - value) / ten_to_the_8 )
+            return false;
+        magnitude = magnitude * ten_to_the_8 + value;
+        n_digits += 8;
+        return true;
+    }
+    uint64 get() const { return magnitude; }
+    size_t size() const { return n_digits; }
+    bool is_overflow() const { return is_overflow_set; }
+};
+
+} // End of anonymous namespace
+
+size_t dsl_pa::read_integer( bool is_signed, uint64 max_magnitude, uint64 * p_magnitude, bool * p_is_negative, bool * p_is_overflow )
+{
+    size_t n_sign_chars = 0;
+    const char * p_begin, * p_end;
+
+    if( p_is_overflow )
+        *p_is_overflow = false;
+
+    // If the integer finishes within the span it can be converted without
+    // recording a location to rewind to
+    if( r_reader.get_span( &p_begin, &p_end ) )
+    {
+        const char * p = p_begin;
+        *p_is_negative = false;
+        if( is_signed && p != p_end && (*p == '-' || *p == '+') )
+        {
+            *p_is_negative = *p == '-';
+            n_sign_chars = 1;
+            ++p;
+        }
+
+        // The magnitude of the most negative value of a two's complement
+        // type is one more than the maximum positive value
+        integer_accumulator accumulator( *p_is_negative ? max_magnitude + 1 : max_magnitude );
+        while( p_end - p >= 8 && accumulator.add_eight( p ) )
+            p += 8;
+        for( ; p != p_end && is_digit( *p ); ++p )
+            accumulator.add( *p );
+
+        if( p != p_end )
+        {
+            if( accumulator.size() == 0 || accumulator.is_overflow() )
+            {
+                if( p_is_overflow )
+                    *p_is_overflow = accumulator.is_overflow();
+                return 0;
+            }
+
+            *p_magnitude = accumulator.get();
+            r_reader.consume( p - p_begin );
+            return p - p_begin;
+        }
+
+        n_sign_chars = 0;
+    }
+
+    locator location( r_reader );
+
+    *p_is_negative = false;
+    char c = get();
+    if( is_signed && (c == '-' || c == '+') )
+    {
+        *p_is_negative = c == '-';
+        n_sign_chars = 1;
+        c = get();
+    }
+
+    integer_accumulator accumulator( *p_is_negative ? max_magnitude + 1 : max_magnitude );
+    for( ; is_digit( c ); c = get() )
+        accumulator.add( c );
+    unget();
+
+    if( accumulator.size() == 0 || accumulator.is_overflow() )
+    {
+        if( p_is_overflow )
+            *p_is_overflow = accumulator.is_overflow();
+        location_top();
+        return 0;
+    }
+
+    *p_magnitude = accumulator.get();
+    return n_sign_chars + accumulator.size();
+}
+
 bool dsl_pa::get_float( std::string * p_num )
 {
     p_num->clear();
@@ -241,15 +396,275 @@ bool dsl_pa::read_float( std::string * p_num )
     return true;
 }
 
-bool dsl_pa::get_float( double * p_float )
+bool dsl_pa::read_fixed_width_uint( uint64 max_value, size_t n_digits, uint64 * p_value )
+{
+    integer_accumulator accumulator( max_value );
+    const char * p_begin, * p_end;
+
+    // If all the digits are in the span there's no need to record a
+    // location to rewind to
+    if( r_reader.get_span( &p_begin, &p_end ) &&
+            static_cast< size_t >( p_end - p_begin ) >= n_digits )
+    {
+        const char * p = p_begin;
+        for( ; n_digits - accumulator.size() >= 8 && accumulator.add_eight( p ); p += 8 )
+        {}
+        for( ; accumulator.size() < n_digits; ++p )
+        {
+            if( ! is_digit( *p ) )
+                return false;
+            accumulator.add( *p );
+        }
+
+        if( accumulator.is_overflow() )
+            return false;
+
+        *p_value = accumulator.get();
+        r_reader.consume( n_digits );
+        return true;
+    }
+
+    locator location( r_reader );
+
+    while( accumulator.size() < n_digits )
+    {
+        char c = get();
+        if( ! is_digit( c ) )
+        {
+            location_top();
+            return false;
+        }
+        accumulator.add( c );
+    }
+
+    if( accumulator.is_overflow() )
+    {
+        location_top();
+        return false;
+    }
+
+    *p_value = accumulator.get();
+    return true;
+}
+
+namespace {
+
+unsigned int hex_digit_value( char c )
+{
+    if( c >= '0' && c <= '9' )
+        return c - '0';
+    if( c >= 'a' && c <= 'f' )
+        return c - 'a' + 10;
+    if( c >= 'A' && c <= 'F' )
+        return c - 'A' + 10;
+    return 0xff;
+}
+
+uint64 bytes_in_range( uint64 chars, char low, char high )
+{
+    // Sets the top bit of each byte of chars in the range low to high.
+    // Bytes must be 7-bit.
+    const uint64 ones = 0x0101010101010101ULL;
+    return (chars + ones * (0x80 - low)) & ~(chars + ones * (0x7f - high)) & (ones * 0x80);
+}
+
+bool eight_hex_digits_value( uint64 chars, uint64 * p_value )
+{
+    // chars holds the first char in its lowest byte, as from
+    // load_eight_chars().  Each byte is validated and converted to its
+    // nibble value, and the nibbles are then packed into 32 bits.
+    const uint64 ones = 0x0101010101010101ULL;
+    const uint64 top_bits = ones * 0x80;
+    if( (chars & top_bits) != 0 )
+        return false;
+    uint64 is_decimal = bytes_in_range( chars, '0', '9' );
+    uint64 is_letter = bytes_in_range( chars | (ones * 0x20), 'a', 'f' );
+    if( (is_decimal | is_letter) != top_bits )
+        return false;
+    uint64 nibbles = (chars & (ones * 0x0f)) + (is_letter >> 7) * 9;
+    nibbles = ((nibbles << 4) | (nibbles >> 8)) & 0x00FF00FF00FF00FFULL;
+    nibbles = ((nibbles << 8) | (nibbles >> 16)) & 0x0000FFFF0000FFFFULL;
+    *p_value = ((nibbles << 16) | (nibbles >> 32)) & 0xFFFFFFFFULL;
+    return true;
+}
+
+class radix_accumulator
+{
+    // Accumulates an unsigned integer whose radix is a power of 2, noting
+    // whether it has exceeded the limit, in the same way as
+    // integer_accumulator.
+private:
+    unsigned int radix_bits;
+    uint64 limit;
+    uint64 magnitude;
+    size_t n_digits;
+    bool is_overflow_set;
+
+public:
+    radix_accumulator( unsigned int radix_bits_in, uint64 limit_in )
+        : radix_bits( radix_bits_in ), limit( limit_in ), magnitude( 0 ), n_digits( 0 ), is_overflow_set( false )
+    {}
+
+    bool add( char c )  // Returns false if c is not a digit of the radix
+    {
+        unsigned int digit = hex_digit_value( c );
+        if( (digit >> radix_bits) != 0 )
+            return false;
+        if( magnitude > (limit - digit) >> radix_bits )
+            is_overflow_set = true;
+        else if( ! is_overflow_set )
+            magnitude = (magnitude << radix_bits) + digit;
+        ++n_digits;
+        return true;
+    }
+    bool add_eight_hex( const char * p )
+    {
+        // As integer_accumulator::add_eight(), for hex digits
+        uint64 value;
+        if( radix_bits != 4 || is_overflow_set || ! eight_hex_digits_value( load_eight_chars( p ), &value ) )
+            return false;
+        if( value > limit || magnitude > (limit - value) >> 32 )
+            return false;
+        magnitude = (magnitude << 32) + value;
+        n_digits += 8;
+        return true;
+    }
+    uint64 get() const { return magnitude; }
+    size_t size() const { return n_digits; }
+    bool is_overflow() const { return is_overflow_set; }
+};
+
+} // End of anonymous namespace
+
+size_t dsl_pa::read_radix_uint( unsigned int radix_bits, uint64 max_value, size_t min_digits, size_t max_digits, uint64 * p_value )
+{
+    radix_accumulator accumulator( radix_bits, max_value );
+    const char * p_begin, * p_end;
+
+    // If the digits finish within the span they can be converted without
+    // recording a location to rewind to
+    if( r_reader.get_span( &p_begin, &p_end ) )
+    {
+        const char * p = p_begin;
+        while( max_digits - accumulator.size() >= 8 && p_end - p >= 8 && accumulator.add_eight_hex( p ) )
+            p += 8;
+        while( accumulator.size() < max_digits && p != p_end && accumulator.add( *p ) )
+            ++p;
+
+        if( accumulator.size() == max_digits || p != p_end )
+        {
+            if( accumulator.size() < min_digits || accumulator.size() == 0 || accumulator.is_overflow() )
+                return 0;
+
+            *p_value = accumulator.get();
+            r_reader.consume( accumulator.size() );
+            return accumulator.size();
+        }
+
+        accumulator = radix_accumulator( radix_bits, max_value );
+    }
+
+    locator location( r_reader );
+
+    while( accumulator.size() < max_digits && accumulator.add( get() ) )
+    {}
+    if( accumulator.size() < max_digits )
+        unget();
+
+    if( accumulator.size() < min_digits || accumulator.size() == 0 || accumulator.is_overflow() )
+    {
+        location_top();
+        return 0;
+    }
+
+    *p_value = accumulator.get();
+    return accumulator.size();
+}
+
+namespace {
+
+const char * scan_float( const char * p_begin, const char * p_end, bool is_sci )
+{
+    // Finds the end of the text that read_float(), or read_sci_float() if
+    // is_sci is set, would read from the start of [p_begin, p_end).  Returns
+    // p_begin if there's no number, or 0 if the number may continue beyond
+    // p_end.
+    const char * p = p_begin;
+    if( p == p_end )
+        return 0;
+
+    if( *p == '-' || *p == '+' )
+        if( ++p == p_end )
+            return 0;
+
+    size_t n_digits = 0;
+    for( ; is_digit( *p ); ++n_digits )
+        if( ++p == p_end )
+            return 0;
+
+    if( *p == '.' )
+    {
+        while( *p == '.' )
+            if( ++p == p_end )
+                return 0;
+        for( ; is_digit( *p ); ++n_digits )
+            if( ++p == p_end )
+                return 0;
+    }
+
+    if( n_digits == 0 )
+        return p_begin;
+
+    if( is_sci && (*p == 'e' || *p == 'E') )
+    {
+        const char * p_exponent = p + 1;    // Exponent is only used if it has digits
+        if( p_exponent == p_end )
+            return 0;
+        if( *p_exponent == '-' || *p_exponent == '+' )
+            if( ++p_exponent == p_end )
+                return 0;
+        if( is_digit( *p_exponent ) )
+        {
+            while( is_digit( *p_exponent ) )
+                if( ++p_exponent == p_end )
+                    return 0;
+            p = p_exponent;
+        }
+    }
+
+    return p;
+}
+
+} // End of anonymous namespace
+
+bool dsl_pa::read_float_value( double * p_float, bool is_sci )
 {
+    // If the number finishes within the span it can be converted in place.
+    // Otherwise it's read into a string first.
+    const char * p_begin, * p_end, * p_number_end;
+    if( r_reader.get_span( &p_begin, &p_end ) &&
+            (p_number_end = scan_float( p_begin, p_end, is_sci )) != 0 )
+    {
+        if( p_number_end == p_begin )
+            return false;
+
+        *p_float = float_helpers::decimal_to_double( p_begin, p_number_end );
+        r_reader.consume( p_number_end - p_begin );
+        return true;
+    }
+
     std::string input;
-    if( ! get_float( &input ) )
+    if( ! (is_sci ? get_sci_float( &input ) : get_float( &input )) )
         return false;
-    *p_float = atof( input.c_str() );
+    *p_float = float_helpers::decimal_to_double( input.data(), input.data() + input.size() );
     return true;
 }
 
+bool dsl_pa::get_float( double * p_float )
+{
+    return read_float_value( p_float, false );
+}
+
 bool dsl_pa::get_float( float * p_float )
 {
     double double_value;
@@ -302,13 +717,107 @@ bool dsl_pa::get_sci_float( float * p_float )
 
 bool dsl_pa::get_sci_float( double * p_float )
 {
-    std::string input;
-    if( ! get_sci_float( &input ) )
-        return false;
-    *p_float = atof( input.c_str() );
-    return true;
+    return read_float_value( p_float, true );
+}
+
+namespace {
+
+// Returns the length of the run at the start of [p_begin, p_end) of
+// printable ASCII chars other than '\\' and delimiter.  These are the
+// q-string chars that need no further processing.  Compares a block of chars
+// at a time where the compiler targets a suitable instruction set.
+size_t plain_ascii_run_length( const char * p_begin, const char * p_end, char delimiter )
+{
+    const char * p_c = p_begin;
+#if defined( CL_DSL_PA_AVX2 )
+    // Chars with the top bit set are negative, and so also less than ' '
+    const __m256i space32 = _mm256_set1_epi8( ' ' );
+    const __m256i backslash32 = _mm256_set1_epi8( '\\' );
+    const __m256i delimiter32 = _mm256_set1_epi8( delimiter );
+    for( ; p_end - p_c >= 32; p_c += 32 )
+    {
+        __m256i block = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( p_c ) );
+        unsigned int mask = static_cast< unsigned int >( _mm256_movemask_epi8( _mm256_or_si256(
+                _mm256_cmpgt_epi8( space32, block ),
+                _mm256_or_si256( _mm256_cmpeq_epi8( block, backslash32 ), _mm256_cmpeq_epi8( block, delimiter32 ) ) ) ) );
+        if( mask != 0 )
+            return p_c + simd_helpers::first_set_bit( mask ) - p_begin;
+    }
+#endif
+#if defined( CL_DSL_PA_SSE2 )
+    const __m128i space = _mm_set1_epi8( ' ' );
+    const __m128i backslash = _mm_set1_epi8( '\\' );
+    const __m128i delimiter16 = _mm_set1_epi8( delimiter );
+    for( ; p_end - p_c >= 16; p_c += 16 )
+    {
+        __m128i block = _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_c ) );
+        unsigned int mask = static_cast< unsigned int >( _mm_movemask_epi8( _mm_or_si128(
+                _mm_cmplt_epi8( block, space ),
+                _mm_or_si128( _mm_cmpeq_epi8( block, backslash ), _mm_cmpeq_epi8( block, delimiter16 ) ) ) ) );
+        if( mask != 0 )
+            return p_c + simd_helpers::first_set_bit( mask ) - p_begin;
+    }
+#endif
+    while( p_c != p_end && (*p_c & 0x80) == 0 && *p_c >= ' ' && *p_c != '\\' && *p_c != delimiter )
+        ++p_c;
+    return p_c - p_begin;
+}
+
+// A DFA for validating UTF-8 multibyte chars as defined in RFC 3629:
+//      UTF8-2      = %xC2-DF UTF8-tail
+//      UTF8-3      = %xE0 %xA0-BF UTF8-tail / %xE1-EC 2( UTF8-tail ) /
+//                    %xED %x80-9F UTF8-tail / %xEE-EF 2( UTF8-tail )
+//      UTF8-4      = %xF0 %x90-BF 2( UTF8-tail ) / %xF1-F3 3( UTF8-tail ) /
+//                    %xF4 %x80-8F 2( UTF8-tail )
+//      UTF8-tail   = %x80-BF
+// Each byte is mapped to a class, and the class and current state select
+// the next state.  utf8_accept is both the start state and the state at the
+// end of a complete char.
+
+enum { utf8_accept = 0, utf8_reject = 1 };
+
+// Byte classes: 0 = 00-7F, 1 = 80-8F, 2 = 90-9F, 3 = A0-BF, 4 = C0-C1 and
+// F5-FF (never valid), 5 = C2-DF, 6 = E0, 7 = E1-EC and EE-EF, 8 = ED,
+// 9 = F0, 10 = F1-F3, 11 = F4
+const unsigned char utf8_byte_classes[256] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 00-0F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 10-1F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 20-2F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 30-3F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 40-4F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 50-5F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 60-6F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 70-7F
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 80-8F
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 90-9F
+        3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // A0-AF
+        3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // B0-BF
+        4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,   // C0-CF
+        5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,   // D0-DF
+        6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 7,   // E0-EF
+        9, 10, 10, 10, 11, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4    // F0-FF
+};
+
+const unsigned char utf8_transitions[9][12] = {
+        //  Byte class
+        //  0   1   2   3   4   5   6   7   8   9  10  11
+        {   0,  1,  1,  1,  1,  2,  4,  3,  5,  7,  6,  8 },    // 0: utf8_accept
+        {   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1 },    // 1: utf8_reject
+        {   1,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1 },    // 2: 1 tail to go
+        {   1,  2,  2,  2,  1,  1,  1,  1,  1,  1,  1,  1 },    // 3: 2 tails to go
+        {   1,  1,  1,  2,  1,  1,  1,  1,  1,  1,  1,  1 },    // 4: after E0
+        {   1,  2,  2,  1,  1,  1,  1,  1,  1,  1,  1,  1 },    // 5: after ED
+        {   1,  3,  3,  3,  1,  1,  1,  1,  1,  1,  1,  1 },    // 6: 3 tails to go
+        {   1,  1,  3,  3,  1,  1,  1,  1,  1,  1,  1,  1 },    // 7: after F0
+        {   1,  3,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1 } };  // 8: after F4
+
+inline unsigned int utf8_next_state( unsigned int state, char c )
+{
+    return utf8_transitions[state][utf8_byte_classes[static_cast< unsigned char >( c )]];
 }
 
+} // End of anonymous namespace
+
 class QStringParser : public dsl_pa
 {
     // This is a JSON q-string parser, that can have the delimiters specified.
@@ -340,22 +849,33 @@ private:
     struct Members
     {
         std::string * p_v;
+        char * p_in_place;
         char delimiter;
         AlphabetIsUnescapedAscii alphabet_is_unescaped_ascii;
         bool is_errored;
+        bool is_escape_seen;
 
-        Members( std::string * p_v_in, char delimiter_in )
+        Members( std::string * p_v_in, char * p_in_place_in, char delimiter_in )
             :
             p_v( p_v_in ),
+            p_in_place( p_in_place_in ),
             delimiter( delimiter_in ),
             alphabet_is_unescaped_ascii( delimiter_in ),
-            is_errored( false )
+            is_errored( false ),
+            is_escape_seen( false )
         {}
     } m;
 
 public:
+    // If p_v is 0, the q-string is only checked.  See is_escape_seen().
     QStringParser( cl::dsl_pa * p_dsl_pa, std::string * p_v, char delimiter = '"' )
-        : dsl_pa( p_dsl_pa->get_reader() ), m( p_v, delimiter )
+        : dsl_pa( p_dsl_pa->get_reader() ), m( p_v, 0, delimiter )
+    {}
+    // The unescaped contents are written to p_in_place, which may be the
+    // start of the q-string in the reader's input.  The output never gets
+    // ahead of the input.  See in_place_end().
+    QStringParser( cl::dsl_pa * p_dsl_pa, char * p_in_place, char delimiter = '"' )
+        : dsl_pa( p_dsl_pa->get_reader() ), m( 0, p_in_place, delimiter )
     {}
 
     bool read() // Assumes we have already consumed the opening quotation mark
@@ -363,13 +883,16 @@ public:
         cl::locator loc( this );
 
         cl::accumulator q_string_accumulator( this );
+        if( ! m.p_v )
+            q_string_accumulator.none();
 
         star_qs_char();
 
         if( peek() != m.delimiter )
             error();
 
-        *m.p_v = q_string_accumulator.get();
+        if( m.p_v )
+            *m.p_v = q_string_accumulator.get();
 
         if( m.is_errored )
             location_top();
@@ -382,6 +905,16 @@ public:
         return m.is_errored;
     }
 
+    bool is_escape_seen() const
+    {
+        return m.is_escape_seen;
+    }
+
+    char * in_place_end() const
+    {
+        return m.p_in_place;
+    }
+
 private:
     bool star_qs_char()
     {
@@ -418,89 +951,116 @@ private:
 
     bool unescaped_ascii()
     {
-        return accumulate( m.alphabet_is_unescaped_ascii );
-    }
-
-    static bool is_unescaped_leading_utf8( char c )
-    {
-        // unescaped-utf8        = %x80-FF
-
-        return static_cast<unsigned char>(c) >= 0xc2;
-    }
+        // Where the input is available as a span, a run of chars that need
+        // no further processing is appended in one go
+        const char * p_begin, * p_end;
+        if( get_reader().get_span( &p_begin, &p_end ) )
+        {
+            size_t run_length = plain_ascii_run_length( p_begin, p_end, m.delimiter );
+            if( run_length > 0 )
+            {
+                output_input( p_begin, p_begin + run_length );
+                get_reader().consume( run_length );
+                return true;
+            }
+        }
 
-    static bool is_unescaped_continuation_utf8( char c )
-    {
-        // unescaped-utf8        = %x80-FF
+        if( ! m.alphabet_is_unescaped_ascii.is_sought( get() ) )
+        {
+            unget();
+            return false;
+        }
 
-        return static_cast<unsigned char>(c) >= 0x80 && static_cast<unsigned char>(c) <= 0xbf;
+        return output( current() );
     }
 
     bool unescaped_utf8()
     {
         // unescaped-utf8        = %x80-10FFFF
 
-        cl::accumulator utf8_accumulator( this );
-
-        if( accumulate( cl::alphabet_function( is_unescaped_leading_utf8 ) ) )
+        // Where the input is available as a span, the multibyte chars are
+        // validated in place.  The run continues over plain ASCII chars so
+        // that mixed text is appended in one go.
+        const char * p_begin, * p_end;
+        if( get_reader().get_span( &p_begin, &p_end ) &&
+                p_begin != p_end && (*p_begin & 0x80) != 0 )
         {
-            while( accumulate( cl::alphabet_function( is_unescaped_continuation_utf8 ) ) )
-            {}
-
-            unsigned char c1 = static_cast<unsigned char>( utf8_accumulator.get()[0] );
-            unsigned char c2 = static_cast<unsigned char>( utf8_accumulator.get()[1] );
-            size_t length = utf8_accumulator.get().length();
-
-            if( c1 == 0xef && c2 == 0xbe && ( utf8_accumulator.get()[2] == 0xbe || utf8_accumulator.get()[2] == 0xbf ) ) // U+FFFE & U+FFFF are illegal
-                return error();
-
-            // From RFC 3629 - Make sure sequence is valid (e.g. doesn't encode a surrogate etc.)
-            // UTF8-octets = *( UTF8-char )
-            // UTF8-char   = UTF8-1 / UTF8-2 / UTF8-3 / UTF8-4
-            // UTF8-1      = %x00-7F - (Handled outside this function)
-            // UTF8-2      = %xC2-DF UTF8-tail
-            // UTF8-3      = %xE0 %xA0-BF UTF8-tail / %xE1-EC 2( UTF8-tail ) /
-            //               %xED %x80-9F UTF8-tail / %xEE-EF 2( UTF8-tail )
-            // UTF8-4      = %xF0 %x90-BF 2( UTF8-tail ) / %xF1-F3 3( UTF8-tail ) /
-            //               %xF4 %x80-8F 2( UTF8-tail )
-            // UTF8-tail   = %x80-BF
-            if( (c1 >= 0xc2 && c1 <= 0xdf && length == 2) ||
-                    (c1 == 0xe0 && (c2 >= 0xa0 && c2 <= 0xbf) && length == 3) ||
-                    (c1 >= 0xe1 && c1 <= 0xec && length == 3) ||
-                    (c1 == 0xed && (c2 >= 0x80 && c2 <= 0x9f) && length == 3) ||
-                    (c1 >= 0xee && c1 <= 0xef && length == 3) ||
-                    (c1 == 0xf0 && (c2 >= 0x90 && c2 <= 0xbf) && length == 4) ||
-                    (c1 >= 0xf1 && c1 <= 0xf3 && length == 4) ||
-                    (c1 == 0xf4 && (c2 >= 0x80 && c2 <= 0x8f) && length == 4) )
+            unsigned int state = utf8_accept;
+            const char * p_valid_end = p_begin;
+            for( const char * p = p_begin; p != p_end; ++p )
             {
-                utf8_accumulator.append_to_previous();
+                if( state == utf8_accept && (*p & 0x80) == 0 )
+                {
+                    if( *p < ' ' || *p == '\\' || *p == m.delimiter )
+                        break;
+                    p_valid_end = p + 1;
+                    continue;
+                }
+                state = utf8_next_state( state, *p );
+                if( state == utf8_reject )
+                    return error();
+                if( state == utf8_accept )
+                    p_valid_end = p + 1;
+            }
 
+            // A char that continues beyond the span is handled below
+            if( p_valid_end != p_begin )
+            {
+                output_input( p_begin, p_valid_end );
+                get_reader().consume( p_valid_end - p_begin );
                 return true;
             }
+        }
 
-            return error();
+        char c = get();
+        if( (c & 0x80) == 0 )
+        {
+            unget();
+            return false;
         }
 
-        return false;
+        char sequence[4];
+        size_t length = 0;
+        unsigned int state = utf8_accept;
+        for( ;; )
+        {
+            state = utf8_next_state( state, c );
+            if( state == utf8_reject )
+                return error();
+            sequence[length++] = c;
+            if( state == utf8_accept )
+                break;
+            c = get();
+        }
+
+        output( sequence, sequence + length );
+
+        return true;
     }
 
     bool escape()
     {
         // escape           = %x5C              ; '\'
 
-        return is_get_char( '\\' );
+        if( ! is_get_char( '\\' ) )
+            return false;
+
+        m.is_escape_seen = true;
+
+        return true;
     }
 
     bool escaped_code()
     {
         char c = peek();
-        return ( (c == m.delimiter && accumulator_append( m.delimiter )) ||
-                (c == '\\' && accumulator_append( '\\' )) ||
-                (c == '/' && accumulator_append( '/' )) ||
-                (c == 'b' && accumulator_append( '\b' )) ||
-                (c == 'f' && accumulator_append( '\f' )) ||
-                (c == 'n' && accumulator_append( '\n' )) ||
-                (c == 'r' && accumulator_append( '\r' )) ||
-                (c == 't' && accumulator_append( '\t' )) )
+        return ( (c == m.delimiter && output( m.delimiter )) ||
+                (c == '\\' && output( '\\' )) ||
+                (c == '/' && output( '/' )) ||
+                (c == 'b' && output( '\b' )) ||
+                (c == 'f' && output( '\f' )) ||
+                (c == 'n' && output( '\n' )) ||
+                (c == 'r' && output( '\r' )) ||
+                (c == 't' && output( '\t' )) )
                 && get();   // Consume peeked character if it's one we want
     }
 
@@ -511,11 +1071,9 @@ private:
 
     bool escaped_hex_code()
     {
-        cl::accumulator hex_code_accumulator( this );
-        if( four_HEXDIG() )
+        int code_point;
+        if( four_HEXDIG( &code_point ) )
         {
-            hex_code_accumulator.previous();
-            int code_point = code_point_from_hex( hex_code_accumulator.get() );
             if( is_high_surrogate( code_point ) )
             {
                 return complete_surrogate_pair( code_point );
@@ -526,7 +1084,7 @@ private:
             }
             else
             {
-                accumulator_append( MakeUTF8( code_point_from_hex( hex_code_accumulator.get() ) ).get() );
+                output( MakeUTF8( code_point ).get() );
             }
             return true;
         }
@@ -536,17 +1094,15 @@ private:
 
     bool complete_surrogate_pair( int high_surrogate_code_point )
     {
-        cl::accumulator hex_code_accumulator( this );
+        int low_surrogate_code_point;
 
-        if( escape() && u() && four_HEXDIG() )
+        if( escape() && u() && four_HEXDIG( &low_surrogate_code_point ) )
         {
-            int low_surrogate_code_point = code_point_from_hex( hex_code_accumulator.get() );
             if( ! is_low_surrogate( low_surrogate_code_point ) )
                 return error();
 
             int combined_code_point = code_point_from_surrogates( high_surrogate_code_point, low_surrogate_code_point );
-            hex_code_accumulator.previous();
-            accumulator_append( MakeUTF8( combined_code_point ).get() );
+            output( MakeUTF8( combined_code_point ).get() );
 
             return true;
         }
@@ -554,19 +1110,11 @@ private:
         return error();
     }
 
-    bool four_HEXDIG()
-    {
-        for( size_t i=0; i<4; ++i )
-            if( ! HEXDIG() )
-                return error();
-        return true;
-    }
-
-    bool HEXDIG()
+    bool four_HEXDIG( int * p_code_point )
     {
-        // HEXDIG() = DIGIT() || "A" || "B" || "C" || "D" || "E" || "F"
+        // HEXDIG = DIGIT / "A" / "B" / "C" / "D" / "E" / "F"
 
-        return accumulate( cl::alphabet_hex() );
+        return get_hex( p_code_point, 4, 4 ) == 4 || error();
     }
 
     bool DIGIT()
@@ -576,6 +1124,37 @@ private:
         return accumulate( cl::alphabet_digit() );
     }
 
+    bool output( const char * p_begin, const char * p_end )
+    {
+        if( m.p_in_place )
+        {
+            if( m.p_in_place != p_begin )
+                memmove( m.p_in_place, p_begin, p_end - p_begin );
+            m.p_in_place += p_end - p_begin;
+            return true;
+        }
+
+        return accumulator_append( p_begin, p_end );
+    }
+
+    bool output_input( const char * p_begin, const char * p_end )    // For chars obtained via get_span()
+    {
+        if( m.p_in_place )
+            return output( p_begin, p_end );
+
+        return accumulator_append_input( p_begin, p_end );
+    }
+
+    bool output( char c )
+    {
+        return output( &c, &c + 1 );
+    }
+
+    bool output( const char * p_s )
+    {
+        return output( p_s, p_s + strlen( p_s ) );
+    }
+
     bool error() { m.is_errored = true; return false; }
 };
 
@@ -584,6 +1163,52 @@ bool dsl_pa::get_qstring_contents( std::string * p_string, char delimiter /*= '"
     return QStringParser( this, p_string, delimiter ).read();
 }
 
+bool dsl_pa::get_qstring_contents( string_ref * p_string, char delimiter /*= '"'*/ )
+{
+    return read_qstring_ref( p_string, delimiter, false );
+}
+
+bool dsl_pa::get_qstring_contents_in_place( string_ref * p_string, char delimiter /*= '"'*/ )
+{
+    return read_qstring_ref( p_string, delimiter, true );
+}
+
+bool dsl_pa::read_qstring_ref( string_ref * p_string, char delimiter, bool is_in_place )
+{
+    // The q-string is checked before anything is output.  If it has no
+    // escapes, its contents are the same as the input so can be referred to
+    // in place.  Otherwise it is unescaped into the input if allowed, which
+    // is only done once it is known to be valid.
+    const char * p_begin, * p_end;
+    if( r_reader.is_input_stable() && r_reader.get_span( &p_begin, &p_end ) )
+    {
+        locator loc( this );
+        QStringParser checker( this, static_cast< std::string * >( 0 ), delimiter );
+        if( ! checker.read() )
+            return false;
+
+        const char * p_delimiter;
+        if( ! checker.is_escape_seen() && r_reader.get_span( &p_delimiter, &p_end ) )
+        {
+            p_string->set( p_begin, p_delimiter - p_begin );
+            return true;
+        }
+
+        location_top();
+
+        char * p_in_place = is_in_place ? r_reader.mutable_input( p_begin ) : 0;
+        if( p_in_place )
+        {
+            QStringParser unescaper( this, p_in_place, delimiter );
+            unescaper.read();
+            p_string->set( p_begin, unescaper.in_place_end() - p_in_place );
+            return true;
+        }
+    }
+
+    return QStringParser( this, p_string->set_buffered(), delimiter ).read();
+}
+
 size_t dsl_pa::get( std::string * p_output, const alphabet & r_alphabet )
 {
     p_output->clear();
@@ -626,46 +1251,147 @@ size_t dsl_pa::get( std::string * p_output, mutator & r_mutator )
     return read( p_output, r_mutator );
 }
 
+// Note: Stable_input: When the reader's input is stable, the chars that are
+//       skipped over following a successful get_span() are the chars of the
+//       span, so the result can refer to them in place.
+
+size_t dsl_pa::get( string_ref * p_output, const alphabet & r_alphabet )
+{
+    return get( p_output, r_alphabet, unbounded );
+}
+
+size_t dsl_pa::get( string_ref * p_output, const alphabet & r_alphabet, size_t max_chars )
+{
+    const char * p_begin, * p_end;
+    if( r_reader.is_input_stable() && r_reader.get_span( &p_begin, &p_end ) )  // See Stable_input
+    {
+        size_t n_chars = skip( r_alphabet, max_chars );
+        p_output->set( p_begin, n_chars );
+        return n_chars;
+    }
+
+    return read( p_output->set_buffered(), r_alphabet, max_chars );
+}
+
+size_t dsl_pa::get_until( string_ref * p_output, const alphabet & r_alphabet )
+{
+    return get_bounded_until( p_output, r_alphabet, unbounded );
+}
+
+size_t dsl_pa::get_bounded_until( string_ref * p_output, const alphabet & r_alphabet, size_t max_chars )
+{
+    const char * p_begin, * p_end;
+    if( r_reader.is_input_stable() && r_reader.get_span( &p_begin, &p_end ) )  // See Stable_input
+    {
+        size_t n_chars = skip_bounded_until( r_alphabet, max_chars );
+        p_output->set( p_begin, n_chars );
+        return n_chars;
+    }
+
+    return read_bounded_until( p_output->set_buffered(), r_alphabet, max_chars );
+}
+
 struct writer_read_mode
 {
+    typedef std::string * output_type;
     static void handle_char( std::string * p_output, char c ) { p_output->push_back( c ); }
+    static void handle_span( std::string * p_output, const char * p_begin, const char * p_end ) { p_output->append( p_begin, p_end ); }
     static void handle_string( std::string * p_output, const char * p_new ) { p_output->append( p_new ); }
 };
 
 struct writer_skip_mode
 {
+    typedef std::string * output_type;
     static void handle_char( std::string * /*p_output*/, char /*c*/ ) {}
+    static void handle_span( std::string * /*p_output*/, const char * /*p_begin*/, const char * /*p_end*/ ) {}
     static void handle_string( std::string * /*p_output*/, const char * /*p_new*/ ) {}
 };
 
+struct writer_in_place_mode     // Output is written back into the input.  See get_escaped_until_in_place()
+{
+    typedef char ** output_type;
+    static void handle_char( char ** pp_output, char c ) { *(*pp_output)++ = c; }
+    static void handle_span( char ** pp_output, const char * p_begin, const char * p_end )
+    {
+        if( *pp_output != p_begin )
+            memmove( *pp_output, p_begin, p_end - p_begin );
+        *pp_output += p_end - p_begin;
+    }
+};
+
+// Note: Span_scanning: Where the reader supports it, the handlers below scan
+//       runs of wanted chars directly in the reader's buffer and then
+//       consume() them in one go.  The char that ends a run (and any chars
+//       that can't be accessed as a span) is handled by the original char
+//       at a time code so that current(), unget() and end of input
+//       behaviour is unchanged.
+
 template< typename Twriter >
 size_t dsl_pa::read_or_skip_handler( std::string * p_output, const alphabet & r_alphabet, size_t max_chars )
 {
-    size_t n_chars;
+    size_t n_chars = 0;
+    const char * p_begin, * p_end;
 
-    for( n_chars = 0; n_chars < max_chars; ++n_chars )
+    while( n_chars < max_chars )
     {
+        if( r_reader.get_span( &p_begin, &p_end ) )  // See Span_scanning
+        {
+            if( static_cast< size_t >( p_end - p_begin ) > max_chars - n_chars )
+                p_end = p_begin + (max_chars - n_chars);
+
+            const char * p_scan = p_begin + r_alphabet.sought_prefix_length( p_begin, p_end );
+
+            Twriter::handle_span( p_output, p_begin, p_scan );
+            r_reader.consume( p_scan - p_begin );
+            n_chars += p_scan - p_begin;
+
+            if( p_scan == p_end )
+                continue;
+        }
+
         if( ! r_alphabet.is_sought( get() ) )
+        {
+            unget();
             break;
+        }
 
         Twriter::handle_char( p_output, current() );
+        ++n_chars;
     }
 
-    if( n_chars < max_chars )
-        unget();
-
     return n_chars;
-
 };
 
 template< typename Twriter >
-size_t dsl_pa::read_or_skip_until_handler( std::string * p_output, const alphabet & r_alphabet, char escape_char, size_t max_chars )
+size_t dsl_pa::read_or_skip_until_handler( typename Twriter::output_type p_output, const alphabet & r_alphabet, char escape_char, size_t max_chars )
 {
-    size_t n_chars;
+    size_t n_chars = 0;
     bool is_escaped = false;
+    const char * p_begin, * p_end;
 
-    for( n_chars = 0; n_chars < max_chars; ++n_chars )
+    while( n_chars < max_chars )
     {
+        if( ! is_escaped && r_reader.get_span( &p_begin, &p_end ) )  // See Span_scanning
+        {
+            if( static_cast< size_t >( p_end - p_begin ) > max_chars - n_chars )
+                p_end = p_begin + (max_chars - n_chars);
+
+            // A run is ended by a sought char, the escape char or EOI
+            const char * p_scan = p_begin + r_alphabet.unsought_prefix_length( p_begin, p_end );
+            if( escape_char != reader::R_EOI )
+                if( const void * p_escape = memchr( p_begin, escape_char, p_scan - p_begin ) )
+                    p_scan = static_cast< const char * >( p_escape );
+            if( const void * p_eoi = memchr( p_begin, reader::R_EOI, p_scan - p_begin ) )
+                p_scan = static_cast< const char * >( p_eoi );
+
+            Twriter::handle_span( p_output, p_begin, p_scan );
+            r_reader.consume( p_scan - p_begin );
+            n_chars += p_scan - p_begin;
+
+            if( p_scan == p_end )
+                continue;
+        }
+
         if( get() == reader::R_EOI )
             return n_chars;
 
@@ -686,6 +1412,8 @@ size_t dsl_pa::read_or_skip_until_handler( std::string * p_output, const alphabe
             Twriter::handle_char( p_output, current() );
             is_escaped = false;
         }
+
+        ++n_chars;
     }
 
     if( n_chars < max_chars )
@@ -752,6 +1480,22 @@ size_t dsl_pa::read( std::string * p_output, mutator & r_mutator )
     return read_or_skip_handler< writer_read_mode >( p_output, r_mutator );
 }
 
+size_t dsl_pa::get_escaped_until_in_place( string_ref * p_output, const alphabet & r_alphabet, char escape_char )
+{
+    // Removing escape chars means the output never gets ahead of the input
+    const char * p_begin, * p_end;
+    char * p_in_place;
+    if( r_reader.get_span( &p_begin, &p_end ) && (p_in_place = r_reader.mutable_input( p_begin )) != 0 )
+    {
+        char * p_in_place_end = p_in_place;
+        size_t n_chars = read_or_skip_until_handler< writer_in_place_mode >( &p_in_place_end, r_alphabet, escape_char, unbounded );
+        p_output->set( p_begin, p_in_place_end - p_in_place );
+        return n_chars;
+    }
+
+    return read_escaped_until( p_output->set_buffered(), r_alphabet, escape_char );
+}
+
 size_t dsl_pa::skip( const alphabet & r_alphabet )
 {
     return skip( r_alphabet, unbounded );
@@ -817,6 +1561,10 @@ struct compare_fixed
     {
         return in_char == sought_char;
     }
+    static bool compare( const char * p_in, const char * p_sought, size_t n )
+    {
+        return memcmp( p_in, p_sought, n ) == 0;
+    }
 };
 
 struct compare_ifixed
@@ -826,11 +1574,66 @@ struct compare_ifixed
         return (is_7bit( in_char ) && tolower( in_char ) == tolower( sought_char ))
                 || (! is_7bit( in_char ) && in_char == sought_char);
     }
+    static bool compare( const char * p_in, const char * p_sought, size_t n )
+    {
+        // Compare 8 chars at a time, folding ASCII upper case to lower case
+        // in both.  Chars with the top bit set are left unchanged, so this
+        // gives the same result as the single char compare().
+        size_t i = 0;
+        for( ; i + 8 <= n; i += 8 )
+        {
+            uint64 in, sought;
+            memcpy( &in, p_in + i, 8 );
+            memcpy( &sought, p_sought + i, 8 );
+            if( in != sought && to_lower_8( in ) != to_lower_8( sought ) )
+                return false;
+        }
+        for( ; i < n; ++i )
+            if( ! compare( p_in[i], p_sought[i] ) )
+                return false;
+        return true;
+    }
+    static uint64 to_lower_8( uint64 chars )
+    {
+        const uint64 ones = 0x0101010101010101ULL;
+        const uint64 top_bits = ones * 0x80;
+        uint64 seven_bits = chars & ~top_bits;
+        uint64 is_at_least_A = seven_bits + ones * (0x80 - 'A');
+        uint64 is_above_Z = seven_bits + ones * (0x80 - 'Z' - 1);
+        uint64 is_upper = is_at_least_A & ~is_above_Z & ~chars & top_bits;
+        return chars | (is_upper >> 2);
+    }
 };
 
 template< class Tcomparer >
 bool dsl_pa::read_fixed_or_ifixed( std::string * p_output, const char * p_seeking )
 {
+    const char * p_begin, * p_end;
+    size_t seeking_length = strlen( p_seeking );
+
+    // If the sought text can be compared against a span there's no need
+    // to record a location to rewind to in case of a mismatch.  A span that
+    // is shorter than the sought text can still show a mismatch early on.
+    if( r_reader.get_span( &p_begin, &p_end ) )
+    {
+        size_t span_length = p_end - p_begin;
+
+        if( span_length >= seeking_length )
+        {
+            if( ! Tcomparer::compare( p_begin, p_seeking, seeking_length ) )
+                return false;
+
+            if( p_output )
+                p_output->append( p_begin, seeking_length );
+            r_reader.consume( seeking_length );
+
+            return true;
+        }
+
+        if( ! Tcomparer::compare( p_begin, p_seeking, span_length ) )
+            return false;
+    }
+
     std::string read;
 
     locator location( r_reader );
@@ -865,8 +1668,152 @@ bool dsl_pa::read_ifixed( std::string * p_output, const char * p_seeking )
     return read_fixed_or_ifixed< compare_ifixed >( p_output, p_seeking );
 }
 
+keyword_set::keyword_set( bool is_case_insensitive )
+    : nodes( 1, node( '\0' ) ), is_case_insensitive_set( is_case_insensitive )
+{
+}
+
+keyword_set::keyword_set( const char * const p_keywords[], size_t n_keywords, bool is_case_insensitive )
+    : nodes( 1, node( '\0' ) ), is_case_insensitive_set( is_case_insensitive )
+{
+    for( size_t i = 0; i < n_keywords; ++i )
+        add( p_keywords[i] );
+}
+
+keyword_set & keyword_set::add( const char * p_keyword )
+{
+    size_t node_index = root();
+
+    for( const char * p = p_keyword; *p != '\0'; ++p )
+    {
+        char c = fold( *p );
+        size_t child = next( node_index, c );
+        if( child == 0 )
+        {
+            child = nodes.size();
+            nodes.push_back( node( c ) );
+            nodes[child].next_sibling = nodes[node_index].first_child;
+            nodes[node_index].first_child = child;
+        }
+        node_index = child;
+    }
+
+    if( nodes[node_index].keyword_index == not_found )
+        nodes[node_index].keyword_index = keywords.size();
+    keywords.push_back( p_keyword );
+
+    return *this;
+}
+
+bool dsl_pa::fixed_one_of( const keyword_set & r_keywords, size_t * p_index )
+{
+    return read_fixed_one_of( 0, r_keywords, p_index );
+}
+
+bool dsl_pa::get_fixed_one_of( std::string * p_output, const keyword_set & r_keywords, size_t * p_index )
+{
+    if( p_output )
+        p_output->clear();
+    return read_fixed_one_of( p_output, r_keywords, p_index );
+}
+
+bool dsl_pa::read_fixed_one_of( std::string * p_output, const keyword_set & r_keywords, size_t * p_index )
+{
+    size_t node_index = r_keywords.root();
+    size_t match_index = r_keywords.keyword_index( node_index );
+    size_t match_length = 0;
+
+    // Walk the trie over the span if the walk can be completed within it.
+    // Otherwise fall back to walking it a character at a time and rewinding.
+    const char * p_begin, * p_end;
+    if( r_reader.get_span( &p_begin, &p_end ) )
+    {
+        bool is_walk_complete = false;
+        for( const char * p = p_begin; ! is_walk_complete && p != p_end; ++p )
+        {
+            node_index = r_keywords.next( node_index, *p );
+            if( node_index == r_keywords.root() )
+                is_walk_complete = true;
+            else
+            {
+                if( r_keywords.keyword_index( node_index ) != keyword_set::not_found )
+                {
+                    match_index = r_keywords.keyword_index( node_index );
+                    match_length = p + 1 - p_begin;
+                }
+                is_walk_complete = ! r_keywords.has_next( node_index );
+            }
+        }
+
+        if( is_walk_complete || ! r_keywords.has_next( r_keywords.root() ) )
+        {
+            if( match_index == keyword_set::not_found )
+                return false;
+
+            if( p_output )
+                p_output->append( p_begin, match_length );
+            r_reader.consume( match_length );
+            if( p_index )
+                *p_index = match_index;
+
+            return true;
+        }
+
+        node_index = r_keywords.root();
+        match_index = r_keywords.keyword_index( node_index );
+        match_length = 0;
+    }
+
+    std::string read;
+
+    {
+        locator location( r_reader );
+
+        while( r_keywords.has_next( node_index ) )
+        {
+            node_index = r_keywords.next( node_index, get() );
+            if( node_index == r_keywords.root() )
+                break;
+            read.push_back( current() );
+            if( r_keywords.keyword_index( node_index ) != keyword_set::not_found )
+            {
+                match_index = r_keywords.keyword_index( node_index );
+                match_length = read.size();
+            }
+        }
+
+        location_top();
+    }
+
+    if( match_index == keyword_set::not_found )
+        return false;
+
+    for( size_t i = 0; i < match_length; ++i )
+        get();
+    if( p_output )
+        p_output->append( read, 0, match_length );
+    if( p_index )
+        *p_index = match_index;
+
+    return true;
+}
+
+// Note: Accumulated_spans: With stable input, accumulated chars are recorded
+//       as spans of the input rather than copied.  See accumulator_deferred.
+//       The char at a time code is used when the char isn't wanted so that
+//       current() is the same as before.
+
 bool dsl_pa::accumulate( char c )
 {
+    const char * p_begin, * p_end;
+    if( p_accumulator && r_reader.is_input_stable() &&
+            r_reader.get_span( &p_begin, &p_end ) && *p_begin == c )  // See Accumulated_spans
+    {
+        p_accumulator->append_input( p_begin, p_begin + 1 );
+        r_reader.consume( 1 );
+        return true;
+    }
+
     if( is_get_char( c ) )
     {
         if( p_accumulator )
@@ -878,6 +1825,15 @@ bool dsl_pa::accumulate( char c )
 
 bool dsl_pa::accumulate( const alphabet & r_alphabet )
 {
+    const char * p_begin, * p_end;
+    if( p_accumulator && r_reader.is_input_stable() &&
+            r_reader.get_span( &p_begin, &p_end ) && r_alphabet.is_sought( *p_begin ) )    // See Accumulated_spans
+    {
+        p_accumulator->append_input( p_begin, p_begin + 1 );
+        r_reader.consume( 1 );
+        return true;
+    }
+
     if( r_alphabet.is_sought( get() ) )
     {
         if( p_accumulator )
@@ -890,9 +1846,20 @@ bool dsl_pa::accumulate( const alphabet & r_alphabet )
 
 size_t dsl_pa::accumulate_all( const alphabet & r_alphabet )
 {
-    size_t num = 0;
-    while( accumulate( r_alphabet ) )
-        ++num;
+    if( ! p_accumulator )
+        return skip( r_alphabet );
+
+    const char * p_begin, * p_end;
+    if( r_reader.is_input_stable() && r_reader.get_span( &p_begin, &p_end ) ) // See Accumulated_spans
+    {
+        size_t num = skip( r_alphabet );
+        p_accumulator->append_input( p_begin, p_begin + num );
+        return num;
+    }
+
+    std::string run;
+    size_t num = read( &run, r_alphabet );
+    p_accumulator->append( run );
     return num;
 }
 
@@ -924,6 +1891,25 @@ bool dsl_pa::accumulator_append( const accumulator_deferred & r_a )
     return true;
 }
 
+bool dsl_pa::accumulator_append( const char * p_begin, const char * p_end )
+{
+    if( p_accumulator )
+        p_accumulator->append( p_begin, p_end );
+    return true;
+}
+
+bool dsl_pa::accumulator_append_input( const char * p_begin, const char * p_end )
+{
+    if( p_accumulator )
+    {
+        if( r_reader.is_input_stable() )
+            p_accumulator->append_input( p_begin, p_end );
+        else
+            p_accumulator->append( p_begin, p_end );
+    }
+    return true;
+}
+
 bool dsl_pa::accumulator_to_previous()
 {
     if( p_accumulator )
@@ -948,18 +1934,48 @@ bool dsl_pa::accumulate_atomic( bool is_valid )
 //                             accumulator implementation
 //----------------------------------------------------------------------------
 
-int64 accumulator_deferred::to_int64() const
+namespace {
+
+bool accumulated_magnitude( const std::string & r_accumulated, uint64 max_magnitude, uint64 * p_magnitude, bool * p_is_negative )
 {
-    int64 v;
-    std::istringstream( my_accumulator ) >> v;
-    return v;
+    // As read_integer(), but skips leading space and ignores what follows
+    // the digits
+    const char * p = r_accumulated.c_str();
+    while( is_space( *p ) )
+        ++p;
+    *p_is_negative = *p == '-';
+    if( *p == '-' || *p == '+' )
+        ++p;
+    integer_accumulator accumulator( *p_is_negative ? max_magnitude + 1 : max_magnitude );
+    for( ; is_digit( *p ); ++p )
+        accumulator.add( *p );
+    *p_magnitude = accumulator.get();
+    return ! accumulator.is_overflow();
 }
 
-uint64 accumulator_deferred::to_uint64() const
+} // End of anonymous namespace
+
+bool accumulator_deferred::to_int64( int64 * p_value ) const
 {
-    uint64 v;
-    std::istringstream( my_accumulator ) >> v;
-    return v;
+    uint64 magnitude;
+    bool is_negative;
+    if( ! accumulated_magnitude( get(), (std::numeric_limits< int64 >::max)(), &magnitude, &is_negative ) )
+        return false;
+    *p_value = (is_negative && magnitude != 0) ?
+                    -static_cast< int64 >( magnitude - 1 ) - 1 :    // Avoids overflow at min()
+                    static_cast< int64 >( magnitude );
+    return true;
+}
+
+bool accumulator_deferred::to_uint64( uint64 * p_value ) const
+{
+    uint64 magnitude;
+    bool is_negative;
+    if( ! accumulated_magnitude( get(), (std::numeric_limits< uint64 >::max)(), &magnitude, &is_negative ) ||
+            (is_negative && magnitude != 0) )
+        return false;
+    *p_value = magnitude;
+    return true;
 }
 
 //----------------------------------------------------------------------------
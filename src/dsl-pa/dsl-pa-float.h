@@ -0,0 +1,58 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2012, Codalogic Ltd (http://www.codalogic.com)
+// All rights reserved.
+//
+// The license for this file is based on the BSD-3-Clause license
+// (http://www.opensource.org/licenses/BSD-3-Clause).
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// - Neither the name Codalogic nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Internal helpers for converting the text matched by dsl_pa's float
+// grammar to a double.  Not part of the public interface.
+//----------------------------------------------------------------------------
+
+#ifndef CL_DSL_PA_FLOAT
+#define CL_DSL_PA_FLOAT
+
+namespace cl {
+
+namespace /*cl::*/float_helpers {
+
+// decimal_to_double() converts text of the form matched by
+// dsl_pa::read_float() or read_sci_float() to the nearest double, giving
+// the same result as strtod() in the "C" locale, including where strtod()
+// stops at a second decimal point.  It doesn't allocate unless a value
+// can't be resolved using 19 significant digits.
+double decimal_to_double( const char * p_begin, const char * p_end );
+
+}   // End of namespace cl::float_helpers
+
+} // End of namespace cl
+
+#endif // CL_DSL_PA_FLOAT
@@ -40,37 +40,145 @@
 // Note:    Blank_line_counting: If the last character was a newline (as well
 //          as the current one), then we want to count any following newline
 //          as a genuine newline, and not suppress it.  Setting
-//          current.last_nl_char to '\0' will achieve this.
+//          last_nl_char to '\0' will achieve this.
 //----------------------------------------------------------------------------
 
 #include "dsl-pa/dsl-pa-reader.h"
 
+#include "dsl-pa-simd.h"
+
+#include <algorithm>
+
+#if defined( _WIN32 )
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
 namespace cl {
 
-void line_counter_with_stack::got_char( char c )
+namespace {
+
+using namespace cl::simd_helpers;
+
+// Returns a pointer to the first '\r' or '\n' in [p_c, p_end), or p_end if
+// there isn't one.  Compares a block of chars at a time where the compiler
+// targets a suitable instruction set.
+const char * find_newline( const char * p_c, const char * p_end )
 {
-    int line_number = get_line_number();
-    int column_number = get_column_number();
+#if defined( CL_DSL_PA_AVX2 )
+    const __m256i cr32 = _mm256_set1_epi8( '\r' );
+    const __m256i nl32 = _mm256_set1_epi8( '\n' );
+    for( ; p_end - p_c >= 32; p_c += 32 )
+    {
+        __m256i block = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( p_c ) );
+        unsigned int mask = static_cast< unsigned int >( _mm256_movemask_epi8(
+                _mm256_or_si256( _mm256_cmpeq_epi8( block, cr32 ), _mm256_cmpeq_epi8( block, nl32 ) ) ) );
+        if( mask != 0 )
+            return p_c + first_set_bit( mask );
+    }
+#endif
+#if defined( CL_DSL_PA_SSE2 )
+    const __m128i cr = _mm_set1_epi8( '\r' );
+    const __m128i nl = _mm_set1_epi8( '\n' );
+    for( ; p_end - p_c >= 16; p_c += 16 )
+    {
+        __m128i block = _mm_loadu_si128( reinterpret_cast< const __m128i * >( p_c ) );
+        unsigned int mask = static_cast< unsigned int >( _mm_movemask_epi8(
+                _mm_or_si128( _mm_cmpeq_epi8( block, cr ), _mm_cmpeq_epi8( block, nl ) ) ) );
+        if( mask != 0 )
+            return p_c + first_set_bit( mask );
+    }
+#endif
+    while( p_c != p_end && *p_c != '\r' && *p_c != '\n' )
+        ++p_c;
+    return p_c;
+}
+
+} // End of anonymous namespace
 
-    if( c == '\r' || c == '\n' )
+void lazy_line_counter::extend_index( const char * p_input, size_t offset ) const
+{
+    int line_number = base.line_number;
+    char last_nl_char = base.last_nl_char;
+    if( ! newline_index.empty() )
     {
-        column_number = 0;
-        if( current.last_nl_char == '\0' || current.last_nl_char == c )
+        line_number = newline_index.back().line_number;
+        last_nl_char = newline_index.back().offset + 1 == index_end ? newline_index.back().last_nl_char : '\0';
+    }
+    else if( index_end != base.offset )
+        last_nl_char = '\0';
+
+    const char * p_c = p_input + index_end;
+    const char * p_end = p_input + offset;
+    while( (p_c = find_newline( p_c, p_end )) != p_end )
+    {
+        if( p_c != p_input + index_end && *(p_c - 1) != '\r' && *(p_c - 1) != '\n' )
+            last_nl_char = '\0';
+
+        // Same rules as line_counter_with_stack::got_char()
+        char c = *p_c;
+        if( last_nl_char == '\0' || last_nl_char == c )
             ++line_number;
 
-         if( current.last_nl_char != '\0' )    // See Blank_line_counting
-            current.last_nl_char = '\0';
-         else
-            current.last_nl_char = c;
+        if( last_nl_char != '\0' )    // See Blank_line_counting
+            last_nl_char = '\0';
+        else
+            last_nl_char = c;
+
+        newline entry;
+        entry.offset = p_c - p_input;
+        entry.line_number = line_number;
+        entry.last_nl_char = last_nl_char;
+        newline_index.push_back( entry );
+
+        index_end = ++p_c - p_input;
     }
-    else
+    index_end = offset;
+}
+
+lazy_line_counter::position lazy_line_counter::locate( const char * p_input, size_t offset ) const
+{
+    if( offset <= base.offset )    // Before where lazy counting started. Best we can do
+        return base;
+
+    if( offset > index_end )
+        extend_index( p_input, offset );
+
+    // Find the last newline before offset
+    size_t low = 0, high = newline_index.size();
+    while( low < high )
     {
-        ++column_number;
+        size_t mid = low + (high - low) / 2;
+        if( newline_index[mid].offset < offset )
+            low = mid + 1;
+        else
+            high = mid;
+    }
 
-        current.last_nl_char = '\0';
+    position result;
+    result.offset = offset;
+    if( low == 0 )
+    {
+        result.line_number = base.line_number;
+        result.column_number = base.column_number + static_cast< int >( offset - base.offset );
+        result.last_nl_char = '\0';
+    }
+    else
+    {
+        const newline & r_newline = newline_index[low - 1];
+        result.line_number = r_newline.line_number;
+        result.column_number = static_cast< int >( offset - r_newline.offset - 1 );
+        result.last_nl_char = r_newline.offset + 1 == offset ? r_newline.last_nl_char : '\0';
     }
 
-    set_position( line_number, column_number );
+    return result;
 }
 
 char reader::get()
@@ -78,14 +186,284 @@ char reader::get()
     if( ! unget_buffer.empty() )
     {
         current_char = unget_buffer.reget();
-        line_counter.retrieved_ungot_char( current_char );
+        if( ! is_lazy )
+            line_counter.retrieved_ungot_char( current_char );
     }
     else
     {
         current_char = get_next_input();
-        line_counter.got_char( current_char );
+        if( ! is_lazy )
+            line_counter.got_char( current_char );
     }
     return current_char;
 }
 
+size_t reader::lazy_offset( const char ** pp_begin ) const
+{
+    const char * p_current;
+    source_input( pp_begin, &p_current );
+    size_t offset = p_current - *pp_begin;
+    size_t n_ungot = unget_buffer.size();
+    return offset > n_ungot ? offset - n_ungot : 0;
+}
+
+bool reader::set_lazy_line_counting( bool is_lazy_in )
+{
+    const char * p_begin, * p_current;
+    if( is_lazy_in == is_lazy || ! source_input( &p_begin, &p_current ) )
+        return is_lazy_in == is_lazy;
+
+    size_t offset = lazy_offset( &p_begin );
+    if( is_lazy_in )
+        lazy_counter.start( offset,
+                line_counter.get_line_number(),
+                line_counter.get_column_number(),
+                line_counter.get_last_nl_char() );
+    else
+        line_counter.reset(
+                lazy_counter.get_line_number( p_begin, offset ),
+                lazy_counter.get_column_number( p_begin, offset ),
+                lazy_counter.get_last_nl_char( p_begin, offset ) );
+    is_lazy = is_lazy_in;
+
+    return true;
+}
+
+char * reader::mutable_input( const char * p_input )
+{
+    char * p_mutable = source_mutable( p_input );
+    if( p_mutable && is_lazy )
+    {
+        // The in-place writers only write to input that has been read, but
+        // that may be further than the lazy counter has indexed, and
+        // location_top() may have moved the reader back from there
+        const char * p_begin, * p_current, * p_span_begin;
+        source_input( &p_begin, &p_current );
+        const char * p_end = p_current;
+        source_span( &p_span_begin, &p_end );
+        lazy_counter.index_to( p_begin, p_end - p_begin );
+    }
+    return p_mutable;
+}
+
+bool reader::get_span( const char ** pp_begin, const char ** pp_end )
+{
+    if( ! unget_buffer.empty() || ! source_span( pp_begin, pp_end ) )
+        return false;
+
+    p_span = *pp_begin;
+    return true;
+}
+
+void reader::consume( size_t n )
+{
+    if( n == 0 )
+        return;
+
+    if( ! is_lazy )
+        for( size_t i = 0; i < n; ++i )
+            line_counter.got_char( p_span[i] );
+    current_char = p_span[n - 1];
+    source_consume( n );
+    p_span += n;
+}
+
+reader_mmap::reader_mmap( const char * p_file_name, int advice )
+    :
+    reader_mem_buf( "", 0 ),
+    p_mapping( 0 ),
+    mapping_size( 0 ),
+    is_mapped( false )
+{
+#if defined( _WIN32 )
+    h_mapping = 0;
+    h_file = CreateFileA( p_file_name, GENERIC_READ, FILE_SHARE_READ, 0,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+    if( h_file == INVALID_HANDLE_VALUE )
+        return;
+
+    LARGE_INTEGER file_size;
+    if( ! GetFileSizeEx( h_file, &file_size ) )
+        return;
+
+    if( GetFileType( h_file ) != FILE_TYPE_DISK )
+        return;     // Devices, pipes etc. can't be mapped, so let the caller use another reader
+
+    is_mapped = true;   // An empty file can't be mapped, but is still a valid input
+
+    if( file_size.QuadPart == 0 )
+        return;
+
+    h_mapping = CreateFileMappingA( h_file, 0, PAGE_READONLY, 0, 0, 0 );
+    if( h_mapping )
+        p_mapping = MapViewOfFile( h_mapping, FILE_MAP_READ, 0, 0, 0 );
+    if( ! p_mapping )
+    {
+        is_mapped = false;
+        return;
+    }
+    mapping_size = static_cast< size_t >( file_size.QuadPart );
+#else
+    int fd = open( p_file_name, O_RDONLY );
+    if( fd == -1 )
+        return;
+
+    struct stat file_stat;
+    if( fstat( fd, &file_stat ) == 0 && S_ISREG( file_stat.st_mode ) )  // Devices, FIFOs, /proc files etc. report a size of 0
+    {
+        is_mapped = true;   // An empty file can't be mapped, but is still a valid input
+
+        if( file_stat.st_size > 0 )
+        {
+            void * p = mmap( 0, static_cast< size_t >( file_stat.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( p != MAP_FAILED )
+            {
+                p_mapping = p;
+                mapping_size = static_cast< size_t >( file_stat.st_size );
+            }
+            else
+                is_mapped = false;
+        }
+    }
+
+    close( fd );    // The mapping remains valid after the file is closed
+#endif
+
+    if( p_mapping )
+    {
+        set_buffer( static_cast< const char * >( p_mapping ), mapping_size );
+        advise( advice );
+    }
+}
+
+reader_mmap::~reader_mmap()
+{
+#if defined( _WIN32 )
+    if( p_mapping )
+        UnmapViewOfFile( p_mapping );
+    if( h_mapping )
+        CloseHandle( h_mapping );
+    if( h_file != INVALID_HANDLE_VALUE )
+        CloseHandle( h_file );
+#else
+    if( p_mapping )
+        munmap( p_mapping, mapping_size );
+#endif
+}
+
+bool reader_mmap::advise( int advice )
+{
+    if( ! p_mapping )
+        return false;
+
+#if defined( _WIN32 )
+    return true;    // Windows has no direct equivalent, but FILE_FLAG_SEQUENTIAL_SCAN is set on open
+#else
+    bool is_ok = true;
+    #if defined( MADV_SEQUENTIAL )
+        is_ok = madvise( p_mapping, mapping_size,
+                    (advice & ADVISE_SEQUENTIAL) ? MADV_SEQUENTIAL : MADV_NORMAL ) == 0;
+    #endif
+    #if defined( MADV_WILLNEED )
+        if( advice & ADVISE_WILLNEED )
+            is_ok = madvise( p_mapping, mapping_size, MADV_WILLNEED ) == 0 && is_ok;
+    #endif
+    return is_ok;
+#endif
+}
+
+bool reader_buffered::fill_buffer()
+{
+    // Work out how much of the existing buffer must be kept.  The last char
+    // is always kept so that a following unget() can step back over it.
+    size_t keep_from = buffer_size > 0 ? buffer_size - 1 : 0;
+
+    for( size_t i = 0; i < location_buffer.size(); ++i )
+    {
+        std::streamoff location = location_buffer[i];
+        if( location >= buffer_offset &&
+                static_cast< size_t >( location - buffer_offset ) < keep_from )
+            keep_from = static_cast< size_t >( location - buffer_offset );
+    }
+
+    if( is_seekable() && buffer_size - keep_from > block_size / 2 )
+        keep_from = buffer_size > 0 ? buffer_size - 1 : 0;  // Too much to keep. Seek back if required
+
+    size_t n_kept = buffer_size - keep_from;
+    if( n_kept > 0 && keep_from > 0 )
+        memmove( &buffer[0], &buffer[keep_from], n_kept );
+    buffer_offset += static_cast< std::streamoff >( keep_from );
+    buffer_pos = buffer_size = n_kept;
+
+    // Grow geometrically so that the cost of moving retained input is
+    // amortised, and give memory back once a large retained area is released
+    if( buffer.size() - n_kept < block_size )
+        buffer.resize( std::max( buffer.size() * 2, n_kept + block_size ) );
+    else if( buffer.size() > 4 * block_size && n_kept < block_size )
+        std::vector< char >( buffer.begin(), buffer.begin() + 2 * block_size ).swap( buffer );
+
+    size_t n_read = read_input( &buffer[n_kept], buffer.size() - n_kept );
+    buffer_size += n_read;
+
+    return n_read != 0;
+}
+
+void reader_buffered::seek( std::streamoff offset )
+{
+    seek_input( offset );
+    buffer_offset = offset;
+    buffer_pos = buffer_size = 0;
+}
+
+reader_file::reader_file( const char * p_input_in )
+    :
+    fin( p_input_in, std::ios::binary ),
+    is_seekable_input( fin.is_open() && fin.tellg() != std::streampos( -1 ) )
+{
+    fin.clear();    // In case the tellg() above failed
+}
+
+size_t reader_file::read_input( char * p_buffer, size_t size )
+{
+    fin.read( p_buffer, static_cast< std::streamsize >( size ) );
+    size_t n_read = static_cast< size_t >( fin.gcount() );
+    if( fin.eof() )
+        fin.clear();    // Allow later seeks
+    return n_read;
+}
+
+void reader_file::seek_input( std::streamoff offset )
+{
+    fin.clear();
+    fin.seekg( offset );
+}
+
+reader_fd::~reader_fd()
+{
+    if( is_owner && fd >= 0 )
+    #if defined( _WIN32 )
+        _close( fd );
+    #else
+        close( fd );
+    #endif
+}
+
+size_t reader_fd::read_input( char * p_buffer, size_t size )
+{
+    if( fd < 0 )
+        return 0;
+
+    for( ;; )
+    {
+    #if defined( _WIN32 )
+        int n_read = _read( fd, p_buffer, static_cast< unsigned int >( size ) );
+    #else
+        ssize_t n_read = read( fd, p_buffer, size );
+        if( n_read < 0 && errno == EINTR )
+            continue;
+    #endif
+        return n_read > 0 ? static_cast< size_t >( n_read ) : 0;
+    }
+}
+
 } // End of namespace cl
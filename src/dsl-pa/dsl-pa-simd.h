@@ -0,0 +1,122 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2012, Codalogic Ltd (http://www.codalogic.com)
+// All rights reserved.
+//
+// The license for this file is based on the BSD-3-Clause license
+// (http://www.opensource.org/licenses/BSD-3-Clause).
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// - Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// - Neither the name Codalogic nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//----------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------
+// Internal helpers for the block-at-a-time scanning code in the dsl-pa
+// source files.  Not part of the public interface.
+//
+// CL_DSL_PA_SSE2 and CL_DSL_PA_AVX2 are defined when the compiler targets
+// those instruction sets, and so the corresponding intrinsics can be used
+// anywhere.  CL_DSL_PA_X86 is defined when code for later instruction sets
+// can be compiled into individual functions (marked with
+// CL_DSL_PA_TARGET()) and selected at run-time using has_ssse3() etc.
+//----------------------------------------------------------------------------
+
+#ifndef CL_DSL_PA_SIMD
+#define CL_DSL_PA_SIMD
+
+#if defined( __AVX2__ )
+    #include <immintrin.h>
+    #define CL_DSL_PA_AVX2
+#endif
+#if defined( __SSE2__ ) || defined( _M_X64 ) || (defined( _M_IX86_FP ) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define CL_DSL_PA_SSE2
+#endif
+
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+    #include <immintrin.h>
+    #define CL_DSL_PA_X86
+    #define CL_DSL_PA_TARGET( x ) __attribute__(( target( x ) ))
+#elif defined( _MSC_VER ) && (defined( _M_X64 ) || defined( _M_IX86 ))
+    #include <intrin.h>
+    #include <immintrin.h>
+    #define CL_DSL_PA_X86
+    #define CL_DSL_PA_TARGET( x )
+#endif
+
+namespace cl {
+
+namespace /*cl::*/simd_helpers {
+
+#if defined( _MSC_VER )
+    inline int first_set_bit( unsigned int mask )
+    {
+        unsigned long index;
+        _BitScanForward( &index, mask );
+        return static_cast< int >( index );
+    }
+#else
+    inline int first_set_bit( unsigned int mask )
+    {
+        return __builtin_ctz( mask );
+    }
+#endif
+
+#if defined( CL_DSL_PA_X86 )
+    #if defined( _MSC_VER )
+    inline bool has_ssse3()
+    {
+        int info[4];
+        __cpuid( info, 1 );
+        return (info[2] & (1 << 9)) != 0;
+    }
+    inline bool has_avx2()
+    {
+        int info[4];
+        __cpuid( info, 1 );
+        const int osxsave_and_avx = (1 << 27) | (1 << 28);
+        if( (info[2] & osxsave_and_avx) != osxsave_and_avx || (_xgetbv( 0 ) & 6) != 6 )
+            return false;
+        __cpuidex( info, 7, 0 );
+        return (info[1] & (1 << 5)) != 0;
+    }
+    #else
+    inline bool has_ssse3()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports( "ssse3" ) != 0;
+    }
+    inline bool has_avx2()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports( "avx2" ) != 0;
+    }
+    #endif
+#endif
+
+}   // End of namespace cl::simd_helpers
+
+} // End of namespace cl
+
+#endif // CL_DSL_PA_SIMD